@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <span>
+
+#include <visualizer/Cube.hpp>
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/Iteration.hpp>
+#include <visualizer/Mesh.hpp>
+#include <visualizer/Parent.hpp>
+#include <visualizer/RenderLayer.hpp>
+#include <visualizer/Shader.hpp>
+#include <visualizer/Transform.hpp>
+
+using namespace Visualizer;
+
+constexpr std::size_t CUBE_COUNT{ 1 << 15 };
+constexpr std::size_t ITERATION_ROUNDS{ 32 };
+
+template <typename... Ts> void register_components(EntityDatabaseImpl& database)
+{
+    (database.register_component_desc(getComponentType<Ts>(), ComponentDescriptor::create_desc<Ts>()), ...);
+}
+
+template <typename F> double measure_ns_per_entity(std::size_t entity_count, std::size_t rounds, F&& f)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    for (std::size_t round{ 0 }; round < rounds; ++round) {
+        f();
+    }
+    auto end{ std::chrono::steady_clock::now() };
+    return std::chrono::duration<double, std::nano>(end - start).count() / (entity_count * rounds);
+}
+
+void run_benchmark(std::size_t chunk_byte_budget)
+{
+    EntityDatabaseImpl database{ chunk_byte_budget };
+    register_components<Cube, std::shared_ptr<Mesh>, Material, RenderLayer, Transform, Parent, HomogeneousIteration>(
+        database);
+
+    // The archetypes of the cubes generated by mdh2vis: outer cubes, nested cubes and iterated cubes.
+    auto cube_archetype{ EntityArchetype{}.with<Cube, std::shared_ptr<Mesh>, Material, RenderLayer, Transform>() };
+    auto child_archetype{ cube_archetype.with<Parent>() };
+    auto iterated_archetype{ child_archetype.with<HomogeneousIteration>() };
+
+    auto init_ns{ measure_ns_per_entity(CUBE_COUNT * 3, 1, [&]() {
+        database.init_entities(cube_archetype, CUBE_COUNT);
+        database.init_entities(child_archetype, CUBE_COUNT);
+        database.init_entities(iterated_archetype, CUBE_COUNT);
+    }) };
+
+    // Emulates the drawing of the meshes, which computes the model matrix of each visible cube.
+    // Half of the cubes are placed on the drawn layer.
+    auto query{ EntityDBQuery{}.with_component<RenderLayer, Transform>() };
+    auto window{ database.query_db_window(query) };
+    window.iterate<RenderLayer>(
+        [](std::size_t entity_idx, RenderLayer* layer) { *layer = RenderLayer::layer(entity_idx % 2); });
+    float checksum{ 0.0f };
+    auto iterate_ns{ measure_ns_per_entity(window.size(), ITERATION_ROUNDS, [&]() {
+        window.for_each_chunk<const RenderLayer, const Transform>(
+            [&](std::span<const RenderLayer> layers, std::span<const Transform> transforms) {
+                for (std::size_t i{ 0 }; i < layers.size(); ++i) {
+                    if (layers[i] & RenderLayer::layer(0)) {
+                        checksum += getModelMatrix(transforms[i])[3][0];
+                    }
+                }
+            });
+    }) };
+
+    // Print the checksum, so that the iteration can not be optimized away.
+    std::fprintf(stderr, "checksum: %f\n", checksum);
+
+    auto capacity{ [&](const EntityArchetype& archetype) {
+        auto entity{ database.init_entity(archetype) };
+        auto chunk_capacity{ database.fetch_entity_container(entity).chunk_capacity() };
+        database.erase_entity(entity);
+        return chunk_capacity;
+    } };
+
+    std::printf("%10zu %8zu %8zu %8zu %10zu %12.2f %12.2f\n", chunk_byte_budget, capacity(cube_archetype),
+        capacity(child_archetype), capacity(iterated_archetype), window.chunk_size(), init_ns, iterate_ns);
+}
+
+int main()
+{
+    std::printf("cube archetypes, %zu cubes per archetype\n", CUBE_COUNT);
+    std::printf("%10s %8s %8s %8s %10s %12s %12s\n", "budget", "cube", "child", "iterated", "chunks", "init ns",
+        "iterate ns");
+    for (std::size_t chunk_byte_budget{ 1024 }; chunk_byte_budget <= 128 * 1024; chunk_byte_budget *= 2) {
+        run_benchmark(chunk_byte_budget);
+    }
+}
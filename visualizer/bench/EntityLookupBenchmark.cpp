@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <visualizer/EntityDatabase.hpp>
+
+using namespace Visualizer;
+
+struct Payload {
+    float value[4];
+};
+
+constexpr std::size_t ENTITY_COUNT{ 1 << 16 };
+constexpr std::size_t LOOKUP_ROUNDS{ 16 };
+
+template <typename F> double measure_ns_per_lookup(const std::vector<Entity>& entities, F&& f)
+{
+    std::size_t checksum{ 0 };
+    auto start{ std::chrono::steady_clock::now() };
+    for (std::size_t round{ 0 }; round < LOOKUP_ROUNDS; ++round) {
+        for (auto entity : entities) {
+            checksum += f(entity);
+        }
+    }
+    auto end{ std::chrono::steady_clock::now() };
+
+    // Print the checksum, so that the lookups can not be optimized away.
+    std::fprintf(stderr, "checksum: %zu\n", checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / (entities.size() * LOOKUP_ROUNDS);
+}
+
+void run_benchmark(std::size_t chunk_capacity)
+{
+    // Sizes the byte budget so that the chunks hold exactly the requested number of entities.
+    EntityDatabaseImpl database{ chunk_capacity * (sizeof(Entity) + sizeof(Payload)) };
+    auto component_type{ database.register_component_desc(
+        getComponentType<Payload>(), ComponentDescriptor::create_desc<Payload>()) };
+
+    std::vector<Entity> entities{};
+    entities.reserve(ENTITY_COUNT);
+    for (std::size_t i{ 0 }; i < ENTITY_COUNT; ++i) {
+        entities.push_back(database.init_entity(EntityArchetype{ component_type }));
+    }
+
+    // Emulates the previous lookup, which hashed the entity to find its chunk and searched the chunk linearly.
+    std::unordered_map<Entity, std::size_t, EntityHasher> chunk_map{};
+    chunk_map.reserve(ENTITY_COUNT);
+    for (auto entity : entities) {
+        chunk_map.insert({ entity, database.fetch_entity_location(entity).chunk_idx });
+    }
+
+    std::shuffle(entities.begin(), entities.end(), std::mt19937{ 42 });
+
+    auto& container{ database.fetch_entity_container(entities.front()) };
+    auto slot_map_ns{ measure_ns_per_lookup(
+        entities, [&](Entity entity) { return database.fetch_entity_location(entity).entity_idx; }) };
+    auto linear_ns{ measure_ns_per_lookup(entities, [&](Entity entity) {
+        auto chunk_entities{ container.entity_chunk(chunk_map.at(entity)).entities() };
+        return static_cast<std::size_t>(
+            std::distance(chunk_entities.begin(), std::find(chunk_entities.begin(), chunk_entities.end(), entity)));
+    }) };
+
+    std::printf("%10zu %14.2f %14.2f %10.2fx\n", chunk_capacity, slot_map_ns, linear_ns, linear_ns / slot_map_ns);
+}
+
+int main()
+{
+    std::printf("entity lookup, %zu entities, ns per lookup\n", ENTITY_COUNT);
+    std::printf("%10s %14s %14s %11s\n", "chunk", "slot map", "linear find", "speedup");
+    for (auto chunk_capacity : { 32, 256, 4096 }) {
+        run_benchmark(chunk_capacity);
+    }
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <visualizer/Transform.hpp>
+
+using namespace Visualizer;
+
+constexpr std::size_t MATRIX_BUDGET{ std::size_t{ 1 } << 26 };
+
+/// Model matrix as it was computed before the batched kernel, from three full matrices.
+glm::mat4 get_reference_model_matrix(const Transform& transform)
+{
+    auto translation{ glm::translate(glm::mat4{ 1.0f }, transform.position) };
+    auto rotation{ glm::toMat4(transform.rotation) };
+    auto scale = glm::scale(glm::mat4{ 1.0f }, transform.scale);
+
+    return translation * rotation * scale;
+}
+
+template <typename F> double measure_ns_per_matrix(std::span<const glm::mat4> matrices, std::size_t rounds, F&& f)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    for (std::size_t round{ 0 }; round < rounds; ++round) {
+        f();
+    }
+    auto end{ std::chrono::steady_clock::now() };
+
+    // Print the checksum, so that the computation can not be optimized away.
+    float checksum{ 0.0f };
+    for (const auto& matrix : matrices) {
+        checksum += matrix[0][0] + matrix[3][0];
+    }
+    std::fprintf(stderr, "checksum: %f\n", checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / (matrices.size() * rounds);
+}
+
+void run_benchmark(std::size_t transform_count)
+{
+    std::mt19937 generator{ 42 };
+    std::uniform_real_distribution<float> distribution{ -1.0f, 1.0f };
+    std::vector<Transform> transforms(transform_count);
+    for (auto& transform : transforms) {
+        auto rotation{ glm::normalize(glm::quat{
+            distribution(generator), distribution(generator), distribution(generator), distribution(generator) }) };
+        transform.rotation = rotation;
+        transform.position = { distribution(generator), distribution(generator), distribution(generator) };
+        transform.scale = { distribution(generator), distribution(generator), distribution(generator) };
+    }
+
+    // Every transform count computes the same number of matrices in total.
+    const auto rounds{ std::max(MATRIX_BUDGET / transform_count, std::size_t{ 1 }) };
+    std::vector<glm::mat4> reference_matrices(transform_count);
+    auto reference_ns{ measure_ns_per_matrix(reference_matrices, rounds, [&]() {
+        for (std::size_t i{ 0 }; i < transform_count; ++i) {
+            reference_matrices[i] = get_reference_model_matrix(transforms[i]);
+        }
+    }) };
+
+    std::vector<glm::mat4> scalar_matrices(transform_count);
+    auto scalar_ns{ measure_ns_per_matrix(scalar_matrices, rounds, [&]() {
+        for (std::size_t i{ 0 }; i < transform_count; ++i) {
+            scalar_matrices[i] = getModelMatrix(transforms[i]);
+        }
+    }) };
+
+    std::vector<glm::mat4> batched_matrices(transform_count);
+    auto batched_ns{ measure_ns_per_matrix(
+        batched_matrices, rounds, [&]() { getModelMatrices(transforms, batched_matrices); }) };
+
+    float max_error{ 0.0f };
+    for (std::size_t i{ 0 }; i < transform_count; ++i) {
+        for (glm::length_t column{ 0 }; column < 4; ++column) {
+            for (glm::length_t row{ 0 }; row < 4; ++row) {
+                auto reference{ reference_matrices[i][column][row] };
+                max_error = std::max(max_error, std::abs(scalar_matrices[i][column][row] - reference));
+                max_error = std::max(max_error, std::abs(batched_matrices[i][column][row] - reference));
+            }
+        }
+    }
+
+    std::printf("%10zu %14.2f %14.2f %14.2f %12.2e\n", transform_count, reference_ns, scalar_ns, batched_ns, max_error);
+}
+
+int main()
+{
+    std::printf("%10s %14s %14s %14s %12s\n", "transforms", "reference ns", "scalar ns", "batched ns", "max error");
+    for (auto transform_count : { std::size_t{ 10'000 }, std::size_t{ 1'000'000 } }) {
+        run_benchmark(transform_count);
+    }
+}
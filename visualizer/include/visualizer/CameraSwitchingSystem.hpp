@@ -14,7 +14,12 @@ class CameraSwitchingSystem : public System {
     void initialize() final;
     void terminate() final;
 
+    void prepare() final;
+    SystemAccess access() const final;
+
 private:
+    bool m_tab_pressed;
+    bool m_switch_camera;
     EntityDBQuery m_camera_switcher_query;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
@@ -14,7 +14,14 @@ class CameraTypeSwitchingSystem : public System {
     void initialize() final;
     void terminate() final;
 
+    void prepare() final;
+    SystemAccess access() const final;
+
 private:
+    bool m_f_pressed;
+    bool m_g_pressed;
+    bool m_toggle_fixed;
+    bool m_toggle_perspective;
     EntityDBQuery m_camera_query;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
@@ -1,8 +1,14 @@
 #pragma once
 
-#include <visualizer/EntityDBQuery.hpp>
+#include <memory>
+
 #include <visualizer/EntityDatabase.hpp>
+#include <visualizer/Iteration.hpp>
+#include <visualizer/Mesh.hpp>
 #include <visualizer/System.hpp>
+#include <visualizer/ThreadPool.hpp>
+#include <visualizer/Transform.hpp>
+#include <visualizer/TypedQuery.hpp>
 
 namespace Visualizer {
 
@@ -14,14 +20,18 @@ class CubeMovementSystem : public System {
     void initialize() final;
     void terminate() final;
 
+    void prepare() final;
+    SystemAccess access() const final;
+
 private:
     double m_accumulator;
     double m_currentTime;
     double m_tick_interval;
     EntityDBQuery m_cubes_query_mesh;
-    EntityDBQuery m_cubes_query_activation;
-    EntityDBQuery m_cubes_query_homogeneous;
-    EntityDBQuery m_cubes_query_heterogeneous;
+    TypedQuery<Write<EntityActivation>> m_cubes_query_activation;
+    TypedQuery<Write<HomogeneousIteration>, Write<Transform>> m_cubes_query_homogeneous;
+    TypedQuery<Write<HeterogeneousIteration>, Write<Transform>> m_cubes_query_heterogeneous;
+    std::shared_ptr<ThreadPool> m_thread_pool;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <iterator>
 
 namespace Visualizer {
 
@@ -15,4 +16,45 @@ struct EntityHasher {
     std::size_t operator()(const Entity& k) const;
 };
 
+class EntityRange {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Entity;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entity*;
+        using reference = Entity;
+
+        Iterator() = default;
+        explicit Iterator(Entity entity);
+
+        Entity operator*() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+
+        bool operator==(const Iterator& other) const;
+
+    private:
+        Entity m_entity{ 0, 0 };
+    };
+
+    EntityRange() = default;
+    EntityRange(Entity first, std::size_t size);
+
+    bool empty() const;
+    std::size_t size() const;
+
+    Entity front() const;
+    Entity back() const;
+    Entity operator[](std::size_t idx) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    Entity m_first{ 0, 0 };
+    std::size_t m_size{ 0 };
+};
+
 }
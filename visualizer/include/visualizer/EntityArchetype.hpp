@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <concepts>
+#include <cstdint>
 #include <optional>
 #include <span>
 #include <string>
@@ -7,6 +10,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include <visualizer/Entity.hpp>
 #include <visualizer/TupleUtils.hpp>
 #include <visualizer/TypeId.hpp>
 #include <visualizer/UniqueTypes.hpp>
@@ -23,10 +27,67 @@ struct ComponentDescriptor {
     void (*copyUninitializedFunc)(const void* src, void* dst);
     void (*moveUninitializedFunc)(void* src, void* dst);
     void (*destructorFunc)(const void* ptr);
+    bool triviallyCopyable;
+    bool triviallyDestructible;
+    /// Compares two values of the component, only set for shared components.
+    bool (*equalFunc)(const void* lhs, const void* rhs);
+    bool shared;
+    bool tag;
+    bool sparse;
+    bool enableable;
+    /// Entity referred to by a relationship component, only set for relationship components.
+    Entity (*targetFunc)(const void* ptr);
 
     bool operator==(const ComponentDescriptor& other);
 
     template <typename T> requires NoCVRefs<T> static ComponentDescriptor create_desc();
+    template <typename T>
+    requires NoCVRefs<T>&& std::equality_comparable<T> static ComponentDescriptor create_shared_desc();
+    template <typename T> requires NoCVRefs<T> static ComponentDescriptor create_sparse_desc();
+    template <typename T> requires NoCVRefs<T> static ComponentDescriptor create_enableable_desc();
+    template <typename T, Entity T::*Target> requires NoCVRefs<T> static ComponentDescriptor create_relationship_desc();
+};
+
+constexpr std::size_t MAX_COMPONENT_TYPES{ 256 };
+
+/// Aborts the program if `component_type` does not fit into a `ComponentSignature`.
+void validate_component_type(TypeId component_type) noexcept;
+
+/// Dense sequential id of a component type, unlike the address based `getTypeId`. Exceeding `MAX_COMPONENT_TYPES`
+/// aborts the program.
+template <typename T> requires NoCVRefs<T> TypeId getComponentType() noexcept;
+template <typename... Ts> requires NoCVRefs<Ts...> std::array<TypeId, sizeof...(Ts)> getComponentTypes() noexcept;
+
+class ComponentSignature {
+public:
+    static constexpr std::size_t WORD_BITS{ 64 };
+    static constexpr std::size_t WORD_COUNT{ MAX_COMPONENT_TYPES / WORD_BITS };
+
+    ComponentSignature() = default;
+    ComponentSignature(std::span<const TypeId> component_types);
+
+    bool operator==(const ComponentSignature& other) const = default;
+    bool operator<(const ComponentSignature& other) const;
+
+    bool empty() const noexcept;
+    std::size_t size() const noexcept;
+    std::size_t hash() const noexcept;
+
+    bool contains(TypeId component_type) const noexcept;
+    bool contains_all(const ComponentSignature& other) const noexcept;
+    bool contains_any(const ComponentSignature& other) const noexcept;
+
+    void insert(TypeId component_type);
+    void erase(TypeId component_type);
+
+    std::vector<TypeId> component_types() const;
+
+private:
+    std::array<std::uint64_t, WORD_COUNT> m_words{};
+};
+
+struct ComponentSignatureHasher {
+    std::size_t operator()(const ComponentSignature& k) const;
 };
 
 class EntityArchetype {
@@ -37,6 +98,7 @@ class EntityArchetype {
 
     EntityArchetype(TypeId component_type);
     EntityArchetype(std::span<const TypeId> component_types);
+    EntityArchetype(const ComponentSignature& signature);
 
     EntityArchetype& operator=(const EntityArchetype&) = default;
     EntityArchetype& operator=(EntityArchetype&&) noexcept = default;
@@ -45,9 +107,11 @@ class EntityArchetype {
 
     std::size_t size() const noexcept;
     std::size_t hash() const noexcept;
-    const std::string& identifier() const noexcept;
+    const ComponentSignature& signature() const noexcept;
     std::span<const TypeId> component_types() const noexcept;
 
+    bool has_component(TypeId component_type) const noexcept;
+
     EntityArchetype with(TypeId component_type) const;
     EntityArchetype with(std::span<const TypeId> component_types) const;
 
@@ -58,8 +122,8 @@ class EntityArchetype {
     template <typename... Ts> requires NoCVRefs<Ts...>&& UniqueTypes<Ts...> EntityArchetype without() const;
 
 private:
-    std::size_t m_hash;
-    std::string m_identifier;
+    std::size_t m_hash{ 0 };
+    ComponentSignature m_signature;
     std::vector<TypeId> m_component_types;
 };
 
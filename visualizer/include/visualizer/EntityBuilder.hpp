@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <visualizer/AlignedMemory.hpp>
+#include <visualizer/EntityArchetype.hpp>
+#include <visualizer/TypeId.hpp>
+#include <visualizer/UniqueTypes.hpp>
+
+namespace Visualizer {
+
+using ComponentType = TypeId;
+
+/// Components without a value are default initialized when the entity is created.
+class EntityBuilder {
+public:
+    struct ComponentValue {
+        ComponentDescriptor descriptor;
+        std::unique_ptr<std::byte, AlignedDeleter<std::byte>> ptr;
+    };
+
+    EntityBuilder() = default;
+    explicit EntityBuilder(const EntityArchetype& archetype);
+    EntityBuilder(const EntityBuilder& other) = delete;
+    EntityBuilder(EntityBuilder&& other) noexcept;
+    ~EntityBuilder() noexcept;
+
+    EntityBuilder& operator=(const EntityBuilder& other) = delete;
+    EntityBuilder& operator=(EntityBuilder&& other) noexcept;
+
+    const EntityArchetype& archetype() const;
+    std::span<const ComponentValue> values() const;
+
+    bool has_value(ComponentType component_type) const;
+
+    EntityBuilder& with(ComponentType component_type);
+
+    template <typename T> requires NoCVRefs<T> EntityBuilder& with();
+    template <typename T> requires NoCVRefs<T> EntityBuilder& with(T&& component);
+    template <typename T> requires NoCVRefs<T> EntityBuilder& with(const T& component);
+
+private:
+    void* init_value(const ComponentDescriptor& descriptor);
+    void clear();
+
+    EntityArchetype m_archetype;
+    std::vector<ComponentValue> m_values;
+};
+
+}
+
+#include <visualizer/EntityBuilder.impl>
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <visualizer/AlignedMemory.hpp>
+#include <visualizer/Entity.hpp>
+#include <visualizer/EntityArchetype.hpp>
+#include <visualizer/TypeId.hpp>
+#include <visualizer/UniqueTypes.hpp>
+
+namespace Visualizer {
+
+class EntityDatabaseContext;
+
+using ComponentType = TypeId;
+
+/// Recording does not require a database context and may happen from multiple threads at once.
+class EntityCommandBuffer {
+public:
+    static constexpr std::size_t DEFERRED_ENTITY_GENERATION{ std::numeric_limits<std::size_t>::max() };
+
+    EntityCommandBuffer() = default;
+    EntityCommandBuffer(const EntityCommandBuffer& other) = delete;
+    EntityCommandBuffer(EntityCommandBuffer&& other) noexcept;
+    ~EntityCommandBuffer() noexcept;
+
+    EntityCommandBuffer& operator=(const EntityCommandBuffer& other) = delete;
+    EntityCommandBuffer& operator=(EntityCommandBuffer&& other) noexcept;
+
+    static bool is_deferred(Entity entity);
+
+    bool empty() const;
+    std::size_t size() const;
+    std::size_t deferred_entity_count() const;
+
+    /// Returns a placeholder, which can be used in the commands of the same buffer.
+    Entity init_entity(const EntityArchetype& archetype);
+    void erase_entity(Entity entity);
+
+    void add_component(Entity entity, ComponentType component_type);
+    void remove_component(Entity entity, ComponentType component_type);
+
+    template <typename T> requires NoCVRefs<T> void add_component(Entity entity);
+    template <typename T> requires NoCVRefs<T> void add_component(Entity entity, T&& component);
+    template <typename T> requires NoCVRefs<T> void add_component(Entity entity, const T& component);
+    template <typename T> requires NoCVRefs<T> void remove_component(Entity entity);
+
+    template <typename T> requires NoCVRefs<T> void write_component(Entity entity, T&& component);
+    template <typename T> requires NoCVRefs<T> void write_component(Entity entity, const T& component);
+
+    void append(EntityCommandBuffer&& other);
+
+    /// The commands are collapsed into one structural change per entity, which are applied grouped by their
+    /// destination archetype. Returns the entities created for the placeholders, in the order of their creation.
+    std::vector<Entity> play_back(EntityDatabaseContext& database_context);
+
+    void clear();
+
+private:
+    enum class CommandType {
+        InitEntity,
+        EraseEntity,
+        AddComponent,
+        RemoveComponent,
+        WriteComponent,
+    };
+
+    static constexpr std::size_t INVALID_IDX{ std::numeric_limits<std::size_t>::max() };
+    static constexpr std::size_t VALUE_BLOCK_SIZE{ 4096 };
+    static constexpr std::size_t VALUE_BLOCK_ALIGNMENT{ 64 };
+
+    struct Command {
+        CommandType type;
+        Entity entity;
+        ComponentType component_type;
+        /// Index of the archetype for `InitEntity`, of the value for `AddComponent` and `WriteComponent`.
+        std::size_t data_idx;
+    };
+
+    struct ComponentValue {
+        ComponentDescriptor descriptor;
+        void* ptr;
+    };
+
+    using ValueBlock = std::unique_ptr<std::byte, AlignedDeleter<std::byte>>;
+
+    template <typename T> requires NoCVRefs<T> std::size_t record_value(T&& component);
+    template <typename T> requires NoCVRefs<T> std::size_t record_value(const T& component);
+
+    void* allocate_value(std::size_t size, std::size_t alignment);
+    void record_command(CommandType type, Entity entity, ComponentType component_type, std::size_t data_idx);
+
+    mutable std::mutex m_mutex;
+    std::size_t m_deferred_entity_count{ 0 };
+    std::size_t m_block_offset{ VALUE_BLOCK_SIZE };
+    std::vector<Command> m_commands;
+    std::vector<EntityArchetype> m_archetypes;
+    std::vector<ComponentValue> m_values;
+    std::vector<ValueBlock> m_value_blocks;
+};
+
+}
+
+#include <visualizer/EntityCommandBuffer.impl>
@@ -1,10 +1,12 @@
 #pragma once
 
-#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <span>
-#include <unordered_map>
 #include <vector>
 
 #include <visualizer/AlignedMemory.hpp>
@@ -13,8 +15,14 @@
 
 namespace Visualizer {
 
-constexpr std::size_t ENTITY_CHUNK_SIZE{ 32 };
 constexpr std::size_t ENTITY_CHUNK_ALLOCATION_BUFFER{ 2 };
+constexpr std::size_t ENTITY_CHUNK_BLOCK_ALIGNMENT{ 64 };
+constexpr std::size_t ENTITY_CHUNK_BYTE_BUDGET{ 16 * 1024 };
+
+/// Index of a distinct value of a shared component, the default value of each shared component has index `0`.
+using SharedValueId = std::size_t;
+
+constexpr SharedValueId DEFAULT_SHARED_VALUE_ID{ 0 };
 
 class EntityContainer;
 class EntityDatabaseImpl;
@@ -24,11 +32,81 @@ struct EntityLocation {
     std::size_t entity_idx;
 };
 
+constexpr EntityLocation INVALID_ENTITY_LOCATION{ std::numeric_limits<std::size_t>::max(),
+    std::numeric_limits<std::size_t>::max() };
+
+/// Blocks of the chunk byte budget of the database are kept in a free list, larger or over-aligned blocks are
+/// allocated on demand.
+class EntityChunkPool {
+public:
+    EntityChunkPool();
+    explicit EntityChunkPool(std::size_t block_size);
+    EntityChunkPool(const EntityChunkPool& other) = delete;
+    EntityChunkPool(EntityChunkPool&& other) noexcept = delete;
+    ~EntityChunkPool() = default;
+
+    EntityChunkPool& operator=(const EntityChunkPool& other) = delete;
+    EntityChunkPool& operator=(EntityChunkPool&& other) noexcept = delete;
+
+    bool is_pooled(std::size_t size, std::size_t alignment) const;
+
+    std::size_t block_size() const;
+
+    std::size_t free_size() const;
+
+    std::byte* allocate(std::size_t size, std::size_t alignment);
+    void release(std::byte* block, std::size_t size, std::size_t alignment);
+    std::size_t trim();
+
+private:
+    std::size_t m_block_size;
+    std::vector<std::unique_ptr<std::byte[], AlignedDeleter<std::byte>>> m_free_blocks;
+};
+
+class SparseComponentSet {
+public:
+    SparseComponentSet(ComponentDescriptor component_desc);
+    SparseComponentSet(const SparseComponentSet& other) = delete;
+    SparseComponentSet(SparseComponentSet&& other) noexcept = delete;
+    ~SparseComponentSet();
+
+    SparseComponentSet& operator=(const SparseComponentSet& other) = delete;
+    SparseComponentSet& operator=(SparseComponentSet&& other) noexcept = delete;
+
+    std::size_t size() const;
+    bool contains(Entity entity) const;
+    std::span<const Entity> entities() const;
+
+    /// Invalidates the values of the other entities, like inserting into a vector.
+    void* init(Entity entity);
+    void erase(Entity entity);
+
+    void* fetch_unchecked(Entity entity);
+    const void* fetch_unchecked(Entity entity) const;
+
+private:
+    static constexpr std::size_t INVALID_IDX{ std::numeric_limits<std::size_t>::max() };
+
+    void reserve(std::size_t capacity);
+
+    ComponentDescriptor m_component_desc;
+    std::size_t m_capacity;
+    std::vector<std::size_t> m_sparse;
+    std::vector<Entity> m_entities;
+    std::unique_ptr<std::byte[], AlignedDeleter<std::byte>> m_values;
+};
+
+/// The chunk capacity is the largest number of entities whose block fits into the byte budget, but at least one.
 class ComponentLayout {
 public:
-    ComponentLayout(const EntityArchetype& archetype, const EntityDatabaseImpl& entity_database);
+    ComponentLayout(
+        const EntityArchetype& archetype, EntityDatabaseImpl& entity_database, std::size_t chunk_byte_budget);
 
     std::size_t size() const;
+    std::size_t chunk_capacity() const;
+    std::size_t block_size() const;
+    std::size_t block_alignment() const;
+    std::size_t component_offset(std::size_t idx) const;
 
     bool has_component(TypeId component_type) const;
     std::size_t component_idx(TypeId component_type) const;
@@ -36,18 +114,42 @@ class ComponentLayout {
 
     std::span<const ComponentDescriptor> component_descriptors() const;
 
+    bool has_shared_component(TypeId component_type) const;
+    std::size_t shared_component_idx(TypeId component_type) const;
+    std::span<const TypeId> shared_component_types() const;
+
     EntityArchetype archetype() const;
+    const ComponentSignature& signature() const;
+
+    const std::atomic<std::size_t>& global_version() const;
+    EntityChunkPool& chunk_pool() const;
 
 private:
+    static constexpr std::size_t INVALID_COMPONENT_IDX{ std::numeric_limits<std::size_t>::max() };
+
+    std::size_t layout_block(std::size_t chunk_capacity);
+
+    std::size_t m_chunk_capacity;
+    std::size_t m_block_size;
+    std::size_t m_block_alignment;
     EntityArchetype m_archetype;
     std::vector<ComponentDescriptor> m_component_descriptors;
+    std::vector<std::size_t> m_component_offsets;
+    std::vector<std::size_t> m_component_indices;
+    std::vector<TypeId> m_shared_component_types;
+    const std::atomic<std::size_t>* m_global_version;
+    EntityChunkPool* m_chunk_pool;
 };
 
+/// Every mutable access stamps the column with the current global version of the database.
 class ComponentChunk {
 public:
-    ComponentChunk(ComponentDescriptor component_data, std::size_t capacity);
+    static constexpr std::size_t ENABLED_WORD_BITS{ 64 };
+
+    ComponentChunk(ComponentDescriptor component_data, std::byte* data, std::size_t capacity,
+        const std::atomic<std::size_t>& global_version);
     ComponentChunk(const ComponentChunk& other) = delete;
-    ComponentChunk(ComponentChunk&& other) noexcept = default;
+    ComponentChunk(ComponentChunk&& other) noexcept;
     ~ComponentChunk();
 
     ComponentChunk& operator=(const ComponentChunk& other) = delete;
@@ -55,11 +157,15 @@ class ComponentChunk {
 
     std::size_t size() const;
     std::size_t capacity() const;
+    std::size_t version() const;
 
     std::size_t init();
+    std::size_t init(std::size_t count);
     std::size_t init_move(void* src);
     std::size_t init_copy(const void* src);
     void erase(std::size_t idx);
+    void erase_move(std::size_t idx, ComponentChunk& src);
+    void clear();
 
     void read(std::size_t idx, void* dst) const;
     void write_move(std::size_t idx, void* src);
@@ -72,20 +178,37 @@ class ComponentChunk {
     void* fetch_unchecked(std::size_t idx);
     const void* fetch_unchecked(std::size_t idx) const;
 
+    /// Columns of enableable components track an enabled bit per entity, new entities start enabled.
+    bool enableable() const;
+    bool is_enabled(std::size_t idx) const;
+    /// Toggling counts as a mutable access and is atomic with respect to the neighbouring entities.
+    void set_enabled(std::size_t idx, bool enabled);
+    std::size_t enabled_size() const;
+    /// Enabled bits, entity `i` is stored in bit `i % 64` of word `i / 64`. The bits past the size are zero.
+    std::span<const std::uint64_t> enabled_words() const;
+
 private:
     std::size_t phantom_init();
+    void stamp_version();
+    void init_enabled(std::size_t idx, std::size_t count);
+    void assign_enabled(std::size_t idx, bool enabled);
 
     std::size_t m_size;
     std::size_t m_capacity;
     ComponentDescriptor m_component_data;
-    std::unique_ptr<std::byte[], AlignedDeleter<std::byte>> m_data;
+    std::byte* m_data;
+    const std::atomic<std::size_t>* m_global_version;
+    std::atomic<std::size_t> m_version;
+    std::atomic<std::size_t> m_enabled_size;
+    std::vector<std::uint64_t> m_enabled_words;
 };
 
 class EntityChunk {
 public:
     EntityChunk(const ComponentLayout& layout);
     EntityChunk(const EntityChunk& other) = delete;
-    EntityChunk(EntityChunk&& other) noexcept = default;
+    EntityChunk(EntityChunk&& other) noexcept;
+    ~EntityChunk();
 
     EntityChunk& operator=(const EntityChunk& other) = delete;
     EntityChunk& operator=(EntityChunk&& other) noexcept;
@@ -94,16 +217,16 @@ class EntityChunk {
     std::size_t capacity() const;
     std::size_t component_size() const;
 
-    bool has_entity(Entity entity) const;
     bool has_component(TypeId component_type) const;
-
-    std::size_t entity_idx(Entity entity) const;
     std::size_t component_idx(TypeId component_type) const;
 
     std::size_t init(Entity entity);
+    std::size_t init(EntityRange entities);
     std::size_t init_move(Entity entity, EntityContainer& entity_container, EntityLocation entity_location);
     std::size_t init_copy(Entity entity, const EntityContainer& entity_container, EntityLocation entity_location);
+
     void erase(std::size_t entity_idx);
+    void erase_move(std::size_t entity_idx, EntityChunk& src);
 
     void read(std::size_t entity_idx, std::size_t component_idx, void* dst) const;
     void write_move(std::size_t entity_idx, std::size_t component_idx, void* src);
@@ -112,37 +235,56 @@ class EntityChunk {
     void* fetch_unchecked(std::size_t entity_idx, std::size_t component_idx);
     const void* fetch_unchecked(std::size_t entity_idx, std::size_t component_idx) const;
 
+    ComponentChunk& component_chunk(std::size_t component_idx);
+    const ComponentChunk& component_chunk(std::size_t component_idx) const;
+
     std::span<const Entity> entities() const;
 
     EntityArchetype archetype() const;
 
 private:
     std::size_t phantom_init(Entity entity);
+    void copy_enabled(std::size_t entity_idx, std::size_t component_idx, const EntityContainer& entity_container,
+        EntityLocation entity_location, std::size_t foreign_component_idx);
+    void release();
 
     std::size_t m_size;
+    std::size_t m_capacity;
     std::reference_wrapper<const ComponentLayout> m_layout;
+    std::byte* m_block;
+    Entity* m_entities;
     std::vector<ComponentChunk> m_component_chunks;
-    std::array<Entity, ENTITY_CHUNK_SIZE> m_entities;
 };
 
 class EntityContainer {
 public:
-    EntityContainer(const EntityArchetype& archetype, const EntityDatabaseImpl& entity_database);
+    /// `shared_value_ids` contains the values of the shared components of the archetype, in ascending type order.
+    EntityContainer(const EntityArchetype& archetype, EntityDatabaseImpl& entity_database,
+        std::size_t chunk_byte_budget = ENTITY_CHUNK_BYTE_BUDGET, std::span<const SharedValueId> shared_value_ids = {});
 
     std::size_t size() const;
     std::size_t capacity() const;
+    std::size_t chunk_capacity() const;
     std::size_t component_size() const;
 
-    bool has_entity(Entity entity) const;
     bool has_component(TypeId component_type) const;
-
-    EntityLocation entity_location(Entity entity) const;
     std::size_t component_idx(TypeId component_type) const;
 
+    bool has_shared_component(TypeId component_type) const;
+    SharedValueId shared_value_id(TypeId component_type) const;
+    std::span<const TypeId> shared_component_types() const;
+    std::span<const SharedValueId> shared_value_ids() const;
+    const void* fetch_shared_unchecked(TypeId component_type) const;
+
     EntityLocation init(Entity entity);
+    /// The entities are stored at consecutive locations, continuing at the start of the next chunk.
+    EntityLocation init(EntityRange entities);
     EntityLocation init_move(Entity entity, EntityContainer& entity_container, EntityLocation entity_location);
     EntityLocation init_copy(Entity entity, const EntityContainer& entity_container, EntityLocation entity_location);
-    void erase(EntityLocation entity_location);
+
+    std::optional<Entity> erase(EntityLocation entity_location);
+    /// No entity changes its location. Returns the number of released chunks.
+    std::size_t shrink_to_fit();
 
     void read(EntityLocation entity_location, std::size_t component_idx, void* dst) const;
     void write_move(EntityLocation entity_location, std::size_t component_idx, void* src);
@@ -158,24 +300,30 @@ class EntityContainer {
     std::span<const EntityChunk> entity_chunks() const;
 
     EntityArchetype archetype() const;
+    const ComponentSignature& signature() const;
+    const ComponentLayout& layout() const;
+
+    std::optional<std::size_t> fetch_add_edge(TypeId component_type) const;
+    std::optional<std::size_t> fetch_remove_edge(TypeId component_type) const;
+
+    void insert_add_edge(TypeId component_type, std::size_t container_id);
+    void insert_remove_edge(TypeId component_type, std::size_t container_id);
 
 private:
-    struct ChunkCapacity {
-        std::size_t chunk_idx;
-        std::size_t chunk_capacity;
-    };
+    static constexpr std::size_t INVALID_EDGE{ std::numeric_limits<std::size_t>::max() };
 
-    /// Returns the index of a suitable chunk and saves the entity.
-    std::size_t phantom_init(Entity entity);
+    /// Returns the index of the first chunk with a free slot.
+    /// The entities are densely packed, only the last chunk may be partially filled.
+    std::size_t phantom_init();
 
     std::size_t m_size;
-    std::size_t m_capacity;
-    std::size_t m_empty_chunks;
-    std::size_t m_filled_chunks;
     ComponentLayout m_layout;
+    std::size_t m_chunk_capacity;
     std::vector<EntityChunk> m_entity_chunks;
-    std::vector<ChunkCapacity> m_capacity_map;
-    std::unordered_map<Entity, std::size_t, EntityHasher> m_entity_map;
+    std::vector<SharedValueId> m_shared_value_ids;
+    std::vector<const void*> m_shared_values;
+    std::vector<std::size_t> m_add_edges;
+    std::vector<std::size_t> m_remove_edges;
 };
 
 }
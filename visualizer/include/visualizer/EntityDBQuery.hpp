@@ -3,7 +3,6 @@
 #include <concepts>
 #include <optional>
 #include <span>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -18,10 +17,18 @@ namespace Visualizer {
 
 using ComponentType = TypeId;
 
+class ComponentChunk;
+class EntityContainer;
 class EntityDBQuery;
 class EntityDBWindow;
+class EntityDatabaseImpl;
 class EntityDatabaseContext;
 class EntityDatabaseLazyContext;
+class SparseComponentSet;
+class ThreadPool;
+template <typename Components, typename Prohibited> class TypedQueryImpl;
+
+using EntityDBQueryId = std::size_t;
 
 template <typename Pred, typename... Ts>
 concept EntityDBWindowPred = std::predicate<Pred, const Ts*...> || std::predicate<Pred, Entity, const Ts*...>;
@@ -33,6 +40,14 @@ concept EntityDBWindowIterateFn
 template <typename Fn, typename... Ts>
 concept EntityDBWindowForEachFn = std::invocable<Fn, Ts*...> || std::invocable<Fn, Entity, Ts*...>;
 
+template <typename Fn, typename... Ts>
+concept EntityDBWindowIterateChunkFn = std::invocable<Fn, std::size_t, std::span<Ts>...> || std::invocable<Fn,
+    std::size_t, std::span<const Entity>, std::span<Ts>...>;
+
+template <typename Fn, typename... Ts>
+concept EntityDBWindowForEachChunkFn
+    = std::invocable<Fn, std::span<Ts>...> || std::invocable<Fn, std::span<const Entity>, std::span<Ts>...>;
+
 class EntityDBQuery {
 public:
     EntityDBQuery() = default;
@@ -55,25 +70,50 @@ class EntityDBQuery {
     std::span<const ComponentType> prohibited_components() const;
     std::span<const ComponentType> optional_components() const;
 
+    bool matches(const EntityArchetype& archetype) const;
+    bool matches(const ComponentSignature& signature) const;
+    bool matches(const EntityDBQuery& other) const;
+
     EntityDBWindow query_db_window(EntityDatabaseContext& database_context);
+    EntityDBWindow query_db_window(EntityDatabaseLazyContext& database_context);
 
     template <typename... Ts> requires ComponentList<Ts...>&& NoCVRefs<Ts...> EntityDBQuery& with_component();
     template <typename... Ts> requires ComponentList<Ts...>&& NoCVRefs<Ts...> EntityDBQuery& without_component();
     template <typename... Ts> requires ComponentList<Ts...>&& NoCVRefs<Ts...> EntityDBQuery& with_optional_component();
 
 private:
+    friend class EntityDatabaseImpl;
+
     std::vector<ComponentType> m_required_components;
     std::vector<ComponentType> m_prohibited_components;
     std::vector<ComponentType> m_optional_components;
+    ComponentSignature m_required_signature;
+    ComponentSignature m_prohibited_signature;
+    ComponentSignature m_optional_signature;
+
+    const EntityDatabaseImpl* m_registered_database{ nullptr };
+    EntityDBQueryId m_registered_id{ 0 };
+};
+
+struct EntityDBWindowChunk {
+    std::span<const Entity> entities;
+    std::size_t entity_offset;
+    std::size_t component_offset;
+    std::size_t chunk_entity_idx;
+    std::size_t container_chunk_idx;
+    const EntityContainer* container;
 };
 
 class EntityDBWindow {
 public:
     EntityDBWindow() = default;
-    EntityDBWindow(std::vector<Entity>&& entities, std::vector<std::vector<void*>>&& components,
-        std::unordered_map<ComponentType, std::size_t>&& component_type_map);
+    /// The chunks of a container must be consecutive and ordered by their location inside the container.
+    EntityDBWindow(const EntityDatabaseImpl* database, std::vector<EntityDBWindowChunk>&& chunks,
+        std::vector<ComponentChunk*>&& components, std::vector<ComponentType>&& component_types,
+        std::vector<std::size_t>&& component_sizes);
 
     std::size_t size() const;
+    std::size_t chunk_size() const;
     std::size_t component_size() const;
 
     std::size_t entity_idx(Entity entity) const;
@@ -82,13 +122,31 @@ class EntityDBWindow {
     bool has_entity(Entity entity) const;
     bool has_component(ComponentType component_type) const;
     bool entity_has_component(Entity entity, ComponentType component_type) const;
+    /// Shared, tag and sparse components have no column, so they can not be iterated as spans.
+    bool has_column(std::size_t component_idx) const;
 
+    /// The values of shared components are immutable and may only be fetched through the const overload.
     void* fetch_component_unchecked(std::size_t entity_idx, std::size_t component_idx);
     const void* fetch_component_unchecked(std::size_t entity_idx, std::size_t component_idx) const;
 
-    std::span<const Entity> entity_span() const;
-    std::span<void*> component_span(std::size_t component_idx);
-    std::span<void* const> component_span(std::size_t component_idx) const;
+    /// The mutable overloads stamp the column with the current global version of the database.
+    void* fetch_chunk_component_unchecked(std::size_t chunk_idx, std::size_t component_idx);
+    const void* fetch_chunk_component_unchecked(std::size_t chunk_idx, std::size_t component_idx) const;
+
+    std::span<const Entity> chunk_entities(std::size_t chunk_idx) const;
+
+    /// Returns `nullptr` if the entities of the chunk do not have the shared component.
+    const void* fetch_chunk_shared_component_unchecked(std::size_t chunk_idx, ComponentType component_type) const;
+
+    template <typename T> requires NoCVRefs<T> const T* fetch_chunk_shared_component(std::size_t chunk_idx) const;
+
+    /// Missing optional components are never accessed and report version `0`.
+    std::size_t chunk_version(std::size_t chunk_idx, std::size_t component_idx) const;
+
+    EntityDBWindow changed_since(std::size_t version, std::span<const ComponentType> component_types) const;
+
+    template <typename... Ts>
+    requires ComponentList<Ts...>&& NoCVRefs<Ts...> EntityDBWindow changed_since(std::size_t version) const;
 
     template <typename... Ts, typename Pred>
     requires ComponentList<Ts...>&& EntityDBWindowPred<Pred, Ts...> EntityDBWindow filter(Pred&& pred);
@@ -107,31 +165,75 @@ class EntityDBWindow {
     requires ComponentList<Ts...>&& EntityDBWindowForEachFn<Fn, Ts...>&& EntityDBWindowPred<Pred, Ts...> void for_each(
         Fn&& fn, Pred&& pred);
 
+    /// Missing optional components are passed as empty spans.
+    template <typename... Ts, typename Fn>
+    requires ComponentList<Ts...>&& EntityDBWindowIterateChunkFn<Fn, Ts...> void iterate_chunk(Fn&& fn);
+
+    template <typename... Ts, typename Fn>
+    requires ComponentList<Ts...>&& EntityDBWindowForEachChunkFn<Fn, Ts...> void for_each_chunk(Fn&& fn);
+
+    /// `fn` may only access the components it is invoked with, which keeps the results deterministic.
+    /// Defined in `ParallelQuery.hpp`.
+    template <typename... Ts, typename Fn>
+    requires ComponentList<Ts...>&& EntityDBWindowIterateFn<Fn, Ts...> void iterate_parallel(
+        ThreadPool& thread_pool, Fn&& fn);
+
+    template <typename... Ts, typename Fn>
+    requires ComponentList<Ts...>&& EntityDBWindowForEachFn<Fn, Ts...> void for_each_parallel(
+        ThreadPool& thread_pool, Fn&& fn);
+
 private:
+    template <typename Components, typename Prohibited> friend class TypedQueryImpl;
+
     template <typename... Ts, typename Pred, std::size_t... Is>
     requires ComponentList<Ts...>&& EntityDBWindowPred<Pred, Ts...> EntityDBWindow filter(
         Pred&& pred, std::index_sequence<Is...>);
 
     template <typename... Ts, typename Fn, std::size_t... Is>
-    requires ComponentList<Ts...>&& EntityDBWindowIterateFn<Fn, Ts...> void iterate(
-        Fn&& fn, std::index_sequence<Is...>);
+    requires ComponentList<Ts...>&& EntityDBWindowIterateChunkFn<Fn, Ts...> void iterate_chunk(
+        std::size_t first_chunk, std::size_t last_chunk, Fn&& fn, std::index_sequence<Is...>);
 
+    /// Invokes `fn(chunk_idx, idx, entity, components...)` for every entity, where `idx` is the index of the entity
+    /// inside its chunk. Missing optional components are passed as `nullptr`.
     template <typename... Ts, typename Fn, std::size_t... Is>
-    requires ComponentList<Ts...>&& EntityDBWindowForEachFn<Fn, Ts...> void for_each(
-        Fn&& fn, std::index_sequence<Is...>);
-
-    template <typename... Ts, typename Fn, typename Pred, std::size_t... Is>
-    requires ComponentList<Ts...>&& EntityDBWindowIterateFn<Fn, Ts...>&& EntityDBWindowPred<Pred, Ts...> void iterate(
-        Fn&& fn, Pred&& pred, std::index_sequence<Is...>);
-
-    template <typename... Ts, typename Fn, typename Pred, std::size_t... Is>
-    requires ComponentList<Ts...>&& EntityDBWindowForEachFn<Fn, Ts...>&& EntityDBWindowPred<Pred, Ts...> void for_each(
-        Fn&& fn, Pred&& pred, std::index_sequence<Is...>);
-
-    std::vector<Entity> m_entities;
-    std::vector<std::vector<void*>> m_components;
-    std::unordered_map<ComponentType, std::size_t> m_component_type_map;
-    std::unordered_map<Entity, std::size_t, EntityHasher> m_entity_index_map;
+    void iterate_entities(std::size_t first_chunk, std::size_t last_chunk, Fn&& fn, std::index_sequence<Is...>);
+
+    template <typename T> std::span<T> chunk_component_span(std::size_t chunk_idx, std::size_t component_idx);
+
+    template <typename T> struct ChunkComponentAccess {
+        T* column;
+        T* chunk_value;
+        SparseComponentSet* sparse_set;
+    };
+
+    template <typename T>
+    ChunkComponentAccess<T> chunk_component_access(std::size_t chunk_idx, std::size_t component_idx);
+    template <typename T>
+    static T* fetch_chunk_entity_component(const ChunkComponentAccess<T>& access, Entity entity, std::size_t idx);
+    static void* fetch_sparse_component(SparseComponentSet& sparse_set, Entity entity);
+    const void* fetch_chunk_value(std::size_t chunk_idx, std::size_t component_idx) const;
+    bool is_shared(std::size_t component_idx) const;
+
+    struct ContainerRange {
+        const EntityContainer* container;
+        std::size_t first_chunk;
+        std::size_t last_chunk;
+    };
+
+    std::size_t chunk_idx(std::size_t entity_idx) const;
+    std::optional<std::size_t> find_entity(Entity entity) const;
+    std::size_t parallel_task_count(const ThreadPool& thread_pool) const;
+    std::size_t parallel_task_first_chunk(std::size_t task_idx, std::size_t task_count) const;
+
+    std::size_t m_size{ 0 };
+    const EntityDatabaseImpl* m_database{ nullptr };
+    std::vector<EntityDBWindowChunk> m_chunks;
+    std::vector<ContainerRange> m_container_ranges;
+    std::vector<ComponentChunk*> m_components;
+    std::vector<ComponentType> m_component_types;
+    std::vector<std::size_t> m_component_sizes;
+    std::vector<SparseComponentSet*> m_sparse_sets;
+    std::vector<void*> m_tag_values;
 };
 
 }
@@ -2,18 +2,26 @@
 
 #include <atomic>
 #include <concepts>
+#include <deque>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <span>
 #include <string>
 #include <tuple>
 #include <type_traits>
-#include <unordered_set>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include <visualizer/AlignedMemory.hpp>
 #include <visualizer/Entity.hpp>
 #include <visualizer/EntityArchetype.hpp>
+#include <visualizer/EntityBuilder.hpp>
+#include <visualizer/EntityCommandBuffer.hpp>
 #include <visualizer/EntityContainer.hpp>
 #include <visualizer/EntityDBQuery.hpp>
 #include <visualizer/TypeId.hpp>
@@ -21,21 +29,72 @@
 
 namespace Visualizer {
 
-class EntityBuilder;
 class EntityDatabaseContext;
 class EntityDatabaseLazyContext;
 
 using ComponentType = TypeId;
 
+struct EntityCompactionStatistics {
+    std::size_t reclaimed_bytes{ 0 };
+    std::size_t entity_count{ 0 };
+    std::size_t entity_capacity{ 0 };
+
+    double fill_ratio() const;
+};
+
+using EntityObserverId = std::size_t;
+
+/// The entities relating to the entity with the id `i` are `sources[offsets[i]]` to `sources[offsets[i + 1]]`.
+struct RelationSnapshot {
+    std::vector<std::size_t> offsets;
+    std::vector<Entity> sources;
+};
+
+/// Shares the snapshot of the index, so that it stays valid while other lookups rebuild the index.
+class RelatedEntities {
+public:
+    RelatedEntities() = default;
+    RelatedEntities(std::shared_ptr<const RelationSnapshot> snapshot, std::span<const Entity> entities);
+
+    std::size_t size() const;
+    bool empty() const;
+
+    Entity operator[](std::size_t idx) const;
+    std::span<const Entity>::iterator begin() const;
+    std::span<const Entity>::iterator end() const;
+
+    std::span<const Entity> entities() const;
+
+private:
+    std::shared_ptr<const RelationSnapshot> m_snapshot;
+    std::span<const Entity> m_entities;
+};
+
+struct EntityCommandBufferTicket {
+    std::size_t sync_point;
+    std::size_t entity_offset;
+};
+
+/// Net changes of a component since the observation was last taken, sorted by entity. An entity which lost and
+/// regained the component is listed as written. Writes through windows are not observed.
+struct EntityObservation {
+    std::vector<Entity> added;
+    std::vector<Entity> removed;
+    std::vector<Entity> written;
+
+    bool empty() const;
+};
+
 class EntityDatabaseImpl {
 public:
     EntityDatabaseImpl() = default;
+    explicit EntityDatabaseImpl(std::size_t chunk_byte_budget);
     EntityDatabaseImpl(const EntityDatabaseImpl&) = delete;
-    EntityDatabaseImpl(EntityDatabaseImpl&&) noexcept = default;
-    ~EntityDatabaseImpl() noexcept = default;
+    EntityDatabaseImpl(EntityDatabaseImpl&&) noexcept = delete;
+    ~EntityDatabaseImpl() noexcept;
 
     EntityDatabaseImpl& operator=(const EntityDatabaseImpl&) = delete;
-    EntityDatabaseImpl& operator=(EntityDatabaseImpl&&) noexcept = default;
+    EntityDatabaseImpl& operator=(EntityDatabaseImpl&&) noexcept = delete;
 
     bool has_entity(Entity entity) const;
     bool has_component(ComponentType component_type) const;
@@ -44,11 +103,17 @@ class EntityDatabaseImpl {
     ComponentType register_component_desc(ComponentType component_type, ComponentDescriptor component_desc);
     const ComponentDescriptor& fetch_component_desc(ComponentType component_type) const;
 
+    const void* fetch_shared_component_value(ComponentType component_type, SharedValueId value_id) const;
+
     Entity init_entity(const EntityArchetype& archetype);
     Entity init_entity(EntityBuilder&& entity_builder);
     Entity init_entity(const EntityBuilder& entity_builder);
+    EntityRange init_entities(const EntityArchetype& archetype, std::size_t count);
+    EntityRange init_entities(const EntityBuilder& entity_builder, std::size_t count);
     Entity init_entity_copy(Entity entity, const EntityArchetype& archetype);
     void erase_entity(Entity entity);
+    /// Also erases the entities relating to the entity, recursively. The relationships must not form cycles.
+    void erase_entity_recursive(Entity entity, ComponentType component_type);
 
     void move_entity(Entity entity, const EntityArchetype& archetype);
 
@@ -58,41 +123,173 @@ class EntityDatabaseImpl {
     void remove_component(Entity entity, ComponentType component_type);
 
     void read_component(Entity entity, ComponentType component_type, void* dst) const;
+    /// Writing a shared component moves the entity to the chunks of the new value.
     void write_component_move(Entity entity, ComponentType component_type, void* src);
     void write_component_copy(Entity entity, ComponentType component_type, const void* src);
 
+    /// The values of shared components are immutable and may only be fetched through the const overload.
     void* fetch_component_unchecked(Entity entity, ComponentType component_type);
     const void* fetch_component_unchecked(Entity entity, ComponentType component_type) const;
 
     EntityContainer& fetch_entity_container(Entity entity);
     const EntityContainer& fetch_entity_container(Entity entity) const;
 
+    EntityLocation fetch_entity_location(Entity entity) const;
+    /// Returns `nullptr` if the component is not sparse.
+    SparseComponentSet* fetch_sparse_component_set(ComponentType component_type) const;
+    /// Returns `nullptr` if the component is not a tag.
+    void* fetch_tag_value(ComponentType component_type) const;
+    bool has_column(ComponentType component_type) const;
     EntityArchetype fetch_entity_archetype(Entity entity) const;
 
+    /// Shared components, tags and sparse components have no column and can not be queried.
+    std::size_t fetch_component_version(Entity entity, ComponentType component_type) const;
+
+    /// Disabled components are skipped by the queries requiring them, but remain readable and writable.
+    bool is_component_enabled(Entity entity, ComponentType component_type) const;
+    void set_component_enabled(Entity entity, ComponentType component_type, bool enabled);
+
+    RelatedEntities fetch_related_entities(Entity entity, ComponentType component_type) const;
+
+    std::size_t global_version() const;
+    std::size_t increment_global_version();
+
+    std::size_t archetype_count() const;
+    bool queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const;
+
+    EntityCompactionStatistics compact();
+
+    EntityObserverId register_observer(ComponentType component_type);
+    /// An observer may only be taken from by one thread at a time.
+    EntityObservation take_observation(EntityObserverId observer_id);
+    void publish_observations();
+
+    EntityDBQueryId register_query(const EntityDBQuery& query);
+
+    EntityDBWindow query_db_window(EntityDBQueryId query_id);
+    EntityDBWindow query_db_window(EntityDBQuery& query);
     EntityDBWindow query_db_window(const EntityDBQuery& query);
+    EntityDBWindow query_db_window(const EntityRange& entities);
 
 private:
+    friend class ComponentLayout;
+
     using EntityContainerId = std::size_t;
 
-    Entity generate_new_entity();
-    EntityContainer& fetch_or_init_entity_container(const EntityArchetype& archetype);
+    static constexpr EntityContainerId INVALID_CONTAINER_ID{ std::numeric_limits<EntityContainerId>::max() };
+
+    struct EntitySlot {
+        std::size_t generation;
+        EntityContainerId container_id;
+        EntityLocation location;
+    };
+
+    struct QueryCache {
+        EntityDBQuery query;
+        EntityDBQuery container_query;
+        std::vector<EntityContainerId> container_ids;
+    };
+
+    struct ContainerKey {
+        ComponentSignature signature;
+        std::vector<SharedValueId> shared_value_ids;
+
+        bool operator==(const ContainerKey& other) const = default;
+    };
+
+    struct ContainerKeyHasher {
+        std::size_t operator()(const ContainerKey& k) const;
+    };
 
-    Entity m_last_entity;
-    EntityContainerId m_last_container_id;
+    /// Lookups of lazy contexts may race with the rebuild, which therefore replaces snapshots still held by them.
+    struct RelationIndex {
+        std::mutex mutex;
+        std::atomic<bool> dirty{ true };
+        std::size_t build_version{ 0 };
+        std::size_t validated_version{ 0 };
+        std::shared_ptr<RelationSnapshot> snapshot;
+    };
 
-    std::vector<Entity> m_free_entities;
-    std::vector<EntityContainerId> m_free_container_ids;
+    struct ComponentObserver {
+        ComponentType component_type;
+        EntityObservation observation;
+    };
 
-    std::unordered_map<Entity, EntityContainerId, EntityHasher> m_entities;
-    std::unordered_map<TypeId, ComponentDescriptor> m_component_descriptors;
-    std::unordered_map<EntityContainerId, EntityContainer> m_entity_containers;
-    std::unordered_map<TypeId, std::unordered_set<EntityContainerId>> m_type_associations;
-    std::unordered_map<EntityArchetype, EntityContainerId, EntityArchetypeHasher> m_archetype_map;
+    using WriteLog = std::vector<std::pair<ComponentType, Entity>>;
+
+    bool has_components(const EntityArchetype& archetype) const;
+
+    Entity generate_new_entity();
+    Entity init_entity(EntityContainerId container_id);
+    EntityRange init_entities(EntityContainerId container_id, std::size_t count);
+    void move_to_container(Entity entity, EntityContainerId container_id);
+    void erase_from_container(EntityContainerId container_id, EntityLocation entity_location);
+    void write_shared_component(Entity entity, ComponentType component_type, SharedValueId value_id);
+
+    SharedValueId fetch_or_init_shared_value_move(ComponentType component_type, void* src);
+    SharedValueId fetch_or_init_shared_value_copy(ComponentType component_type, const void* src);
+    std::optional<SharedValueId> find_shared_value(ComponentType component_type, const void* value) const;
+    void* allocate_shared_value(ComponentType component_type);
+
+    EntityArchetype container_archetype(const EntityArchetype& archetype) const;
+    EntityDBQuery container_query(const EntityDBQuery& query) const;
+    void move_sparse_components(Entity entity, const EntityArchetype& archetype);
+
+    void invalidate_relation_indices(EntityContainerId container_id);
+    void invalidate_relation_index(ComponentType component_type);
+    std::shared_ptr<const RelationSnapshot> fetch_relation_snapshot(ComponentType component_type) const;
+    void rebuild_relation_index(ComponentType component_type, RelationIndex& relation_index) const;
+
+    void observe_signature_change(Entity entity, const ComponentSignature& src, const ComponentSignature& dst);
+    void observe_add(Entity entity, ComponentType component_type);
+    void observe_remove(Entity entity, ComponentType component_type);
+    void observe_write(Entity entity, ComponentType component_type);
+    WriteLog& fetch_write_log();
+    void reconcile_observation(EntityObservation& observation, ComponentType component_type) const;
+
+    std::vector<SharedValueId> shared_value_ids(
+        const EntityArchetype& archetype, const EntityContainer* src_container) const;
+    std::vector<SharedValueId> fetch_or_init_shared_value_ids(const EntityBuilder& entity_builder);
+
+    EntityContainerId fetch_or_init_entity_container(
+        const EntityArchetype& archetype, std::span<const SharedValueId> shared_value_ids);
+    EntityContainerId fetch_or_init_add_edge(EntityContainerId container_id, ComponentType component_type);
+    EntityContainerId fetch_or_init_remove_edge(EntityContainerId container_id, ComponentType component_type);
+
+    std::size_t m_chunk_byte_budget{ ENTITY_CHUNK_BYTE_BUDGET };
+    std::atomic<std::size_t> m_global_version{ 1 };
+    /// Declared before the containers, whose chunks return their blocks to the pool on destruction.
+    EntityChunkPool m_chunk_pool;
+
+    /// Guards the registration of queries, registered caches never move.
+    std::mutex m_query_mutex;
+
+    std::vector<EntitySlot> m_entity_slots;
+    std::vector<std::size_t> m_free_entity_ids;
+    std::deque<QueryCache> m_query_caches;
+    std::vector<std::unique_ptr<EntityContainer>> m_entity_containers;
+    std::vector<ComponentSignature> m_container_signatures;
+
+    std::vector<std::optional<ComponentDescriptor>> m_component_descriptors;
+    std::vector<std::vector<std::unique_ptr<std::byte, AlignedDeleter<std::byte>>>> m_shared_component_values;
+    ComponentSignature m_shared_components;
+    ComponentSignature m_tag_components;
+    std::vector<std::unique_ptr<SparseComponentSet>> m_sparse_component_sets;
+    ComponentSignature m_sparse_components;
+    std::vector<std::unique_ptr<RelationIndex>> m_relation_indices;
+    ComponentSignature m_relation_components;
+    std::deque<ComponentObserver> m_observers;
+    std::vector<EntityObservation> m_recorded_observations;
+    ComponentSignature m_observed_components;
+    std::vector<std::shared_ptr<WriteLog>> m_write_logs;
+    std::mutex m_observer_mutex;
+    std::unordered_map<ContainerKey, EntityContainerId, ContainerKeyHasher> m_container_map;
 };
 
 class EntityDatabase : public GenericManager {
 public:
     EntityDatabase() = default;
+    explicit EntityDatabase(std::size_t chunk_byte_budget);
     EntityDatabase(const EntityDatabase& other) = delete;
     EntityDatabase(EntityDatabase&& other) noexcept = delete;
     ~EntityDatabase() noexcept;
@@ -108,9 +305,30 @@ class EntityDatabase : public GenericManager {
     template <typename F>
     requires std::invocable<F, const EntityDatabaseLazyContext&> void enter_secure_lazy_context(F&& f) const;
 
+    /// May be called from any thread without a context.
+    EntityCommandBufferTicket submit_command_buffer(EntityCommandBuffer&& command_buffer);
+    std::vector<Entity> play_back_command_buffers();
+    /// Only the entities created at the last sync point can be resolved.
+    Entity resolve_entity(const EntityCommandBufferTicket& ticket, Entity placeholder) const;
+
+    EntityCompactionStatistics compact();
+    /// `0` disables the automatic compaction.
+    void set_auto_compaction(std::size_t idle_sync_points);
+
+    std::size_t global_version() const;
+    std::size_t increment_global_version();
+
 private:
     mutable std::shared_mutex m_context_mutex;
     mutable EntityDatabaseImpl m_database_impl;
+
+    mutable std::mutex m_command_buffer_mutex;
+    EntityCommandBuffer m_command_buffer;
+    std::size_t m_sync_point{ 0 };
+    std::vector<Entity> m_created_entities;
+
+    std::size_t m_auto_compaction_idle_sync_points{ 0 };
+    std::size_t m_idle_sync_points{ 0 };
 };
 
 class EntityDatabaseContext {
@@ -133,8 +351,11 @@ class EntityDatabaseContext {
     Entity init_entity(const EntityArchetype& archetype);
     Entity init_entity(EntityBuilder&& entity_builder);
     Entity init_entity(const EntityBuilder& entity_builder);
+    EntityRange init_entities(const EntityArchetype& archetype, std::size_t count);
+    EntityRange init_entities(const EntityBuilder& entity_builder, std::size_t count);
     Entity init_entity_copy(Entity entity, const EntityArchetype& archetype);
     void erase_entity(Entity entity);
+    void erase_entity_recursive(Entity entity, ComponentType component_type);
 
     void move_entity(Entity entity, const EntityArchetype& archetype);
 
@@ -155,9 +376,34 @@ class EntityDatabaseContext {
 
     EntityArchetype fetch_entity_archetype(Entity entity) const;
 
+    std::size_t fetch_component_version(Entity entity, ComponentType component_type) const;
+    bool is_component_enabled(Entity entity, ComponentType component_type) const;
+    void set_component_enabled(Entity entity, ComponentType component_type, bool enabled);
+    RelatedEntities fetch_related_entities(Entity entity, ComponentType component_type) const;
+    std::size_t global_version() const;
+
+    std::size_t archetype_count() const;
+    bool queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const;
+
+    EntityCompactionStatistics compact();
+
+    EntityObserverId register_observer(ComponentType component_type);
+    EntityObservation take_observation(EntityObserverId observer_id);
+
+    EntityDBQueryId register_query(const EntityDBQuery& query);
+
+    EntityDBWindow query_db_window(EntityDBQueryId query_id);
+    EntityDBWindow query_db_window(EntityDBQuery& query);
     EntityDBWindow query_db_window(const EntityDBQuery& query);
+    EntityDBWindow query_db_window(const EntityRange& entities);
 
     template <typename T> requires NoCVRefs<T> ComponentType register_component_desc();
+    template <typename T>
+    requires NoCVRefs<T>&& std::equality_comparable<T> ComponentType register_shared_component_desc();
+    template <typename T> requires NoCVRefs<T> ComponentType register_sparse_component_desc();
+    template <typename T> requires NoCVRefs<T> ComponentType register_enableable_component_desc();
+    template <typename T, Entity T::*Target> requires NoCVRefs<T> ComponentType register_relationship_component_desc();
+    template <typename T> requires NoCVRefs<T> EntityObserverId register_observer();
 
     template <typename T> requires NoCVRefs<T> bool entity_has_component(Entity entity) const;
 
@@ -166,6 +412,8 @@ class EntityDatabaseContext {
     template <typename T> requires NoCVRefs<T> void add_component(Entity entity, const T& component);
     template <typename T> requires NoCVRefs<T> void remove_component(Entity entity);
 
+    template <typename T> requires NoCVRefs<T> void erase_entity_recursive(Entity entity);
+
     template <typename T> requires NoCVRefs<T> T read_component(Entity entity) const;
     template <typename T> requires NoCVRefs<T> void write_component(Entity entity, T&& component);
     template <typename T> requires NoCVRefs<T> void write_component(Entity entity, const T& component);
@@ -173,6 +421,13 @@ class EntityDatabaseContext {
     template <typename T> requires NoCVRefs<T> T& fetch_component_unchecked(Entity entity);
     template <typename T> requires NoCVRefs<T> const T& fetch_component_unchecked(Entity entity) const;
 
+    template <typename T> requires NoCVRefs<T> std::size_t fetch_component_version(Entity entity) const;
+
+    template <typename T> requires NoCVRefs<T> bool is_component_enabled(Entity entity) const;
+    template <typename T> requires NoCVRefs<T> void set_component_enabled(Entity entity, bool enabled);
+
+    template <typename T> requires NoCVRefs<T> RelatedEntities fetch_related_entities(Entity entity) const;
+
 private:
     EntityDatabaseImpl& m_database;
 };
@@ -200,6 +455,39 @@ class EntityDatabaseLazyContext {
 
     EntityArchetype fetch_entity_archetype(Entity entity) const;
 
+    std::size_t fetch_component_version(Entity entity, ComponentType component_type) const;
+    bool is_component_enabled(Entity entity, ComponentType component_type) const;
+    void set_component_enabled(Entity entity, ComponentType component_type, bool enabled);
+    RelatedEntities fetch_related_entities(Entity entity, ComponentType component_type) const;
+    std::size_t global_version() const;
+
+    std::size_t archetype_count() const;
+    bool queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const;
+
+    EntityObservation take_observation(EntityObserverId observer_id);
+
+    EntityDBQueryId register_query(const EntityDBQuery& query);
+
+    EntityDBWindow query_db_window(EntityDBQueryId query_id);
+    EntityDBWindow query_db_window(EntityDBQuery& query);
+    EntityDBWindow query_db_window(const EntityDBQuery& query);
+
+    template <typename T> requires NoCVRefs<T> bool entity_has_component(Entity entity) const;
+
+    template <typename T> requires NoCVRefs<T> T read_component(Entity entity) const;
+    template <typename T> requires NoCVRefs<T> void write_component(Entity entity, T&& component);
+    template <typename T> requires NoCVRefs<T> void write_component(Entity entity, const T& component);
+
+    template <typename T> requires NoCVRefs<T> T& fetch_component_unchecked(Entity entity);
+    template <typename T> requires NoCVRefs<T> const T& fetch_component_unchecked(Entity entity) const;
+
+    template <typename T> requires NoCVRefs<T> std::size_t fetch_component_version(Entity entity) const;
+
+    template <typename T> requires NoCVRefs<T> bool is_component_enabled(Entity entity) const;
+    template <typename T> requires NoCVRefs<T> void set_component_enabled(Entity entity, bool enabled);
+
+    template <typename T> requires NoCVRefs<T> RelatedEntities fetch_related_entities(Entity entity) const;
+
 private:
     EntityDatabaseImpl& m_database;
 };
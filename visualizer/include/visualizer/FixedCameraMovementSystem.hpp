@@ -14,8 +14,23 @@ class FixedCameraMovementSystem : public System {
     void initialize() final;
     void terminate() final;
 
+    void prepare() final;
+    SystemAccess access() const final;
+
 private:
+    struct Input {
+        bool active;
+        bool w_key;
+        bool a_key;
+        bool s_key;
+        bool d_key;
+        bool q_key;
+        bool e_key;
+        float movement_speed;
+    };
+
     double m_current_time;
+    Input m_input;
     EntityDBQuery m_camera_query;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
@@ -19,13 +19,29 @@ class FreeFlyCameraMovementSystem : public System {
     void initialize() final;
     void terminate() final;
 
+    void prepare() final;
+    SystemAccess access() const final;
+
 private:
+    struct Input {
+        bool active;
+        bool w_key;
+        bool a_key;
+        bool s_key;
+        bool d_key;
+        bool q_key;
+        bool e_key;
+        float movement_speed;
+        glm::vec3 mouse_rotation;
+    };
+
     double m_mouse_x;
     double m_mouse_y;
     double m_current_time;
     float m_movement_speed;
     float m_rotation_speed;
     float m_movement_multiplier;
+    Input m_input;
     EntityDBQuery m_camera_query;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Visualizer {
+
+/// Model matrix of the entity, which includes the transforms of all its parents.
+struct LocalToWorld {
+    glm::mat4 matrix;
+};
+
+static_assert(sizeof(LocalToWorld) == sizeof(glm::mat4), "a column of LocalToWorld must be an array of matrices");
+
+}
@@ -1,12 +1,22 @@
 #pragma once
 
+#include <glm/glm.hpp>
 #include <memory>
+#include <span>
+#include <vector>
 
+#include <visualizer/Camera.hpp>
 #include <visualizer/EntityDBQuery.hpp>
 #include <visualizer/EntityDatabase.hpp>
 #include <visualizer/Framebuffer.hpp>
+#include <visualizer/LocalToWorld.hpp>
+#include <visualizer/Mesh.hpp>
+#include <visualizer/RenderLayer.hpp>
+#include <visualizer/Shader.hpp>
 #include <visualizer/System.hpp>
 #include <visualizer/Texture.hpp>
+#include <visualizer/Transform.hpp>
+#include <visualizer/TypedQuery.hpp>
 
 namespace Visualizer {
 
@@ -19,8 +29,32 @@ class MeshDrawingSystem : public System {
     void terminate() final;
 
 private:
+    struct DrawBatch {
+        const std::shared_ptr<Mesh>* mesh;
+        const Material* material;
+        std::span<const RenderLayer> layers;
+        std::span<const LocalToWorld> model_matrices;
+        RenderLayer any_layers;
+        RenderLayer all_layers;
+        std::size_t layers_version;
+    };
+
+    /// Entity of a batch, the draw list is sorted by the entity ids.
+    struct DrawCommand {
+        Entity entity;
+        std::size_t batch_idx;
+        std::size_t entity_idx;
+    };
+
+    void update_draw_list(EntityDatabaseContext& database_context);
+    void update_layer_summary(DrawBatch& draw_batch, const DrawBatch* previous_batch, std::size_t layers_version,
+        std::size_t version) const;
+
     EntityDBQuery m_mesh_query;
-    EntityDBQuery m_camera_query;
+    TypedQuery<Write<Camera>, Read<Transform>> m_camera_query;
+    std::vector<DrawBatch> m_draw_batches;
+    std::vector<DrawBatch> m_previous_draw_batches;
+    std::vector<DrawCommand> m_draw_list;
     std::shared_ptr<EntityDatabase> m_entity_database;
 };
 
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <visualizer/EntityDBQuery.hpp>
+#include <visualizer/ThreadPool.hpp>
+#include <visualizer/TypedQuery.hpp>
+
+/// Kept apart from the queries, so that only the callers of the parallel iterations depend on the `ThreadPool`.
+#include <visualizer/ParallelQuery.impl>
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <visualizer/Entity.hpp>
 
 namespace Visualizer {
@@ -6,4 +8,4 @@ struct Parent {
     Entity m_parent;
 };
 
-}
\ No newline at end of file
+}
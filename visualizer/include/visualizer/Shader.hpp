@@ -230,6 +230,9 @@ class ShaderEnvironment {
     ShaderEnvironment& operator=(const ShaderEnvironment& other);
     ShaderEnvironment& operator=(ShaderEnvironment&& other) noexcept = default;
 
+    /// Compares the parameters bytewise, i.e. textures are compared by identity.
+    bool operator==(const ShaderEnvironment& other) const;
+
     std::span<std::string_view> parameters() const;
 
     template <typename T>
@@ -351,6 +354,8 @@ class ShaderEnvironment {
         std::size_t pos;
         std::size_t size;
         ParameterType type;
+
+        bool operator==(const ParameterInfo& other) const = default;
     };
 
     std::size_t m_dataSize;
@@ -442,6 +447,8 @@ class ShaderProgram {
 struct Material {
     ShaderEnvironment m_materialVariables;
     std::shared_ptr<ShaderProgram> m_shader;
+
+    bool operator==(const Material& other) const = default;
 };
 
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <visualizer/SystemAccess.hpp>
 #include <visualizer/World.hpp>
 
 namespace Visualizer {
@@ -17,6 +18,10 @@ class System : public GenericManager {
     virtual void initialize() = 0;
     virtual void terminate() = 0;
 
+    /// Called on the main thread before the pass is run, e.g. to poll the input.
+    virtual void prepare() { }
+    virtual SystemAccess access() const { return SystemAccess::exclusive_access(); }
+
 protected:
     System() = default;
 };
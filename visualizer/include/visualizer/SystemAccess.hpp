@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include <visualizer/EntityDBQuery.hpp>
+#include <visualizer/TypeId.hpp>
+#include <visualizer/UniqueTypes.hpp>
+
+namespace Visualizer {
+
+/// The SystemManager runs systems of the same pass concurrently, if their accesses do not conflict.
+struct SystemAccess {
+    struct ComponentAccess {
+        EntityDBQuery query;
+        ComponentType component_type;
+        bool write;
+    };
+
+    /// The system may change the structure of the entity database or touch undeclared data.
+    bool exclusive{ false };
+    bool main_thread{ false };
+    std::vector<ComponentAccess> components{};
+
+    static SystemAccess exclusive_access();
+
+    template <typename... Ts>
+    requires ComponentList<Ts...>&& NoCVRefs<Ts...> SystemAccess& read(const EntityDBQuery& query);
+    template <typename... Ts>
+    requires ComponentList<Ts...>&& NoCVRefs<Ts...> SystemAccess& write(const EntityDBQuery& query);
+
+    bool conflicts(const SystemAccess& other, const EntityDatabaseLazyContext& database_context) const;
+};
+
+}
+
+#include <visualizer/SystemAccess.impl>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <concepts>
 #include <map>
 #include <memory>
@@ -29,6 +30,14 @@ class SystemParameterMap {
     std::unordered_map<TypeId, void*> m_parameters;
 };
 
+struct SystemPassStatistics {
+    std::size_t system_count{ 0 };
+    std::chrono::duration<double> system_time{ 0 };
+    std::chrono::duration<double> wall_time{ 0 };
+
+    double parallelism() const;
+};
+
 class SystemManager : public GenericManager {
 public:
     SystemManager() = default;
@@ -45,6 +54,8 @@ class SystemManager : public GenericManager {
 
     void run(std::string_view pass, const SystemParameterMap& parameters = {});
 
+    SystemPassStatistics getStatistics(std::string_view pass) const;
+
     template <typename T>
     requires NoCVRefs<T>&& std::derived_from<T, System> bool hasSystem(std::string_view pass) const;
     template <typename T>
@@ -57,9 +68,22 @@ class SystemManager : public GenericManager {
     addSystem(std::string_view pass, Args&&... args);
 
 private:
+    /// The dependency graph depends on the archetypes of the entity database and is rebuilt when new ones are added.
+    struct SystemSchedule {
+        bool m_exclusive;
+        std::size_t m_begin;
+        std::size_t m_end;
+        std::size_t m_archetypeCount;
+        std::vector<bool> m_mainThread;
+        std::vector<std::size_t> m_dependencyCounts;
+        std::vector<std::vector<std::size_t>> m_dependents;
+    };
+
     struct SystemPass {
         std::unordered_map<TypeId, std::size_t> m_systemMap;
         std::vector<std::tuple<std::shared_ptr<System>, TypeId>> m_systems;
+        std::vector<SystemSchedule> m_schedules;
+        SystemPassStatistics m_statistics;
     };
 
     struct StringCmp {
@@ -67,6 +91,13 @@ class SystemManager : public GenericManager {
         bool operator()(std::string_view a, std::string_view b) const { return a < b; }
     };
 
+    void buildSchedules(SystemPass& systemPass);
+    void updateSchedule(SystemPass& systemPass, SystemSchedule& schedule);
+    std::chrono::duration<double> runSystem(
+        const SystemPass& systemPass, std::size_t index, const SystemParameterMap& parameters);
+    std::chrono::duration<double> runSchedule(
+        const SystemPass& systemPass, const SystemSchedule& schedule, const SystemParameterMap& parameters);
+
     std::vector<SystemPass> m_passes;
     std::map<std::string, std::size_t, StringCmp> m_passesMap;
 };
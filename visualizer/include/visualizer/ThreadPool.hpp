@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <visualizer/World.hpp>
+
+namespace Visualizer {
+
+class ThreadPool : public GenericManager {
+public:
+    using Task = std::function<void()>;
+
+    ThreadPool();
+    explicit ThreadPool(std::size_t worker_count);
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool(ThreadPool&& other) noexcept = delete;
+    ~ThreadPool() override;
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+    ThreadPool& operator=(ThreadPool&& other) noexcept = delete;
+
+    std::size_t worker_count() const;
+
+    void submit(Task task);
+
+    bool run_pending_task();
+
+    /// The calling thread only helps with the tasks of this call, so that nested calls from within a task can not
+    /// dead-lock and never pick up unrelated work.
+    template <typename F> requires std::invocable<F, std::size_t> void parallel_for(std::size_t task_count, F&& fn);
+
+private:
+    /// Identifies the tasks of one `parallel_for` call, `nullptr` matches every task.
+    using TaskGroup = const void*;
+
+    struct GroupedTask {
+        Task task;
+        TaskGroup group;
+    };
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<GroupedTask> tasks;
+    };
+
+    void submit(Task task, TaskGroup group);
+    bool run_pending_task(TaskGroup group);
+    void worker_loop(std::size_t worker_idx);
+    bool pop_task(std::size_t queue_idx, TaskGroup group, Task& task);
+    bool steal_task(std::size_t queue_idx, TaskGroup group, Task& task);
+
+    bool m_stop;
+    std::atomic<std::size_t> m_pending_tasks;
+    std::atomic<std::size_t> m_next_queue;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_condition;
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+};
+
+}
+
+#include <visualizer/ThreadPool.impl>
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -14,4 +16,6 @@ struct Transform {
 
 glm::mat4 getModelMatrix(const Transform& transform);
 
-}
\ No newline at end of file
+void getModelMatrices(std::span<const Transform> transforms, std::span<glm::mat4> matrices);
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/LocalToWorld.hpp>
+#include <visualizer/Parent.hpp>
+#include <visualizer/System.hpp>
+#include <visualizer/Transform.hpp>
+#include <visualizer/TypedQuery.hpp>
+
+namespace Visualizer {
+
+/// Only the entities whose transform, parent or parent matrix changed since the last run are recomputed.
+class TransformPropagationSystem : public System {
+public:
+    TransformPropagationSystem();
+
+    void run(void* data) final;
+    void initialize() final;
+    void terminate() final;
+
+    SystemAccess access() const final;
+
+private:
+    void push_children(const EntityDatabaseLazyContext& database_context, Entity entity, bool changed);
+
+    std::size_t m_last_version;
+    TypedQuery<Read<Transform>, Write<LocalToWorld>, Without<Parent>> m_root_query;
+    TypedQuery<Read<Transform>, Read<Parent>, Write<LocalToWorld>> m_child_query;
+    std::vector<std::tuple<Entity, bool>> m_traversal_stack;
+    std::shared_ptr<EntityDatabase> m_entity_database;
+};
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <concepts>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <visualizer/Entity.hpp>
+#include <visualizer/EntityDBQuery.hpp>
+#include <visualizer/SystemAccess.hpp>
+#include <visualizer/UniqueTypes.hpp>
+
+namespace Visualizer {
+
+template <typename T> requires NoCVRefs<T> struct Read {
+};
+
+template <typename T> requires NoCVRefs<T> struct Write {
+};
+
+template <typename T> requires NoCVRefs<T> struct Without {
+};
+
+template <typename A> struct TypedQueryAccessor {
+    static constexpr bool valid{ false };
+};
+
+template <typename T> struct TypedQueryAccessor<Read<T>> {
+    static constexpr bool valid{ true };
+    using components = std::tuple<const T>;
+    using prohibited = std::tuple<>;
+};
+
+template <typename T> struct TypedQueryAccessor<Write<T>> {
+    static constexpr bool valid{ true };
+    using components = std::tuple<T>;
+    using prohibited = std::tuple<>;
+};
+
+template <typename T> struct TypedQueryAccessor<Without<T>> {
+    static constexpr bool valid{ true };
+    using components = std::tuple<>;
+    using prohibited = std::tuple<T>;
+};
+
+template <typename... As> concept TypedQueryAccessorList = (TypedQueryAccessor<As>::valid && ...);
+
+template <typename Context>
+concept TypedQueryContext = std::same_as<Context, EntityDatabaseContext> || std::same_as<Context,
+    EntityDatabaseLazyContext>;
+
+template <typename Fn, typename... Ts>
+concept TypedQueryForEachFn = std::invocable<Fn&, Ts&...> || std::invocable<Fn&, Entity, Ts&...>;
+
+template <typename Fn, typename... Ts>
+concept TypedQueryIterateChunkFn = std::invocable<Fn&, std::size_t, std::span<Ts>...> || std::invocable<Fn&,
+    std::size_t, std::span<const Entity>, std::span<Ts>...>;
+
+template <typename Fn, typename... Ts>
+concept TypedQueryForEachChunkFn
+    = std::invocable<Fn&, std::span<Ts>...> || std::invocable<Fn&, std::span<const Entity>, std::span<Ts>...>;
+
+template <typename Components, typename Prohibited> class TypedQueryImpl;
+
+/// The columns are resolved once per chunk, after which the callback is invoked from a plain loop over the columns.
+/// Shared, tag and sparse components are fetched per entity instead.
+template <typename... Ts, typename... Us> class TypedQueryImpl<std::tuple<Ts...>, std::tuple<Us...>> {
+public:
+    static_assert(sizeof...(Ts) != 0, "a typed query must access at least one component");
+    static_assert(ComponentList<std::remove_const_t<Ts>..., Us...>, "the components must be unique");
+
+    TypedQueryImpl();
+    TypedQueryImpl(const TypedQueryImpl& other) = default;
+    TypedQueryImpl(TypedQueryImpl&& other) noexcept = default;
+    ~TypedQueryImpl() noexcept = default;
+
+    TypedQueryImpl& operator=(const TypedQueryImpl& other) = default;
+    TypedQueryImpl& operator=(TypedQueryImpl&& other) noexcept = default;
+
+    const EntityDBQuery& query() const;
+    SystemAccess& declare_access(SystemAccess& access) const;
+
+    template <TypedQueryContext Context> EntityDBWindow query_db_window(Context& database_context);
+
+    /// The window must contain all components of the query.
+    template <typename Fn> requires TypedQueryForEachFn<Fn, Ts...> void for_each(EntityDBWindow& window, Fn&& fn);
+    template <TypedQueryContext Context, typename Fn>
+    requires TypedQueryForEachFn<Fn, Ts...> void for_each(Context& database_context, Fn&& fn);
+
+    template <typename Fn>
+    requires TypedQueryIterateChunkFn<Fn, Ts...> void iterate_chunk(EntityDBWindow& window, Fn&& fn);
+    template <TypedQueryContext Context, typename Fn>
+    requires TypedQueryIterateChunkFn<Fn, Ts...> void iterate_chunk(Context& database_context, Fn&& fn);
+
+    template <typename Fn>
+    requires TypedQueryForEachChunkFn<Fn, Ts...> void for_each_chunk(EntityDBWindow& window, Fn&& fn);
+    template <TypedQueryContext Context, typename Fn>
+    requires TypedQueryForEachChunkFn<Fn, Ts...> void for_each_chunk(Context& database_context, Fn&& fn);
+
+    /// Defined in `ParallelQuery.hpp`.
+    template <typename Fn>
+    requires TypedQueryForEachFn<Fn, Ts...> void for_each_parallel(
+        EntityDBWindow& window, ThreadPool& thread_pool, Fn&& fn);
+    template <TypedQueryContext Context, typename Fn>
+    requires TypedQueryForEachFn<Fn, Ts...> void for_each_parallel(
+        Context& database_context, ThreadPool& thread_pool, Fn&& fn);
+
+private:
+    template <typename Fn>
+    static void for_each_entity(Fn& fn, EntityDBWindow& window, std::size_t first_chunk, std::size_t last_chunk);
+
+    EntityDBQuery m_query;
+};
+
+/// The callbacks receive the read and written components in the order of the accessors, e.g.
+/// `TypedQuery<Read<A>, Without<B>, Write<C>>` invokes `fn(const A&, C&)` or `fn(Entity, const A&, C&)`.
+template <typename... As>
+requires TypedQueryAccessorList<As...> using TypedQuery
+    = TypedQueryImpl<decltype(std::tuple_cat(std::declval<typename TypedQueryAccessor<As>::components>()...)),
+        decltype(std::tuple_cat(std::declval<typename TypedQueryAccessor<As>::prohibited>()...))>;
+
+}
+
+#include <visualizer/TypedQuery.impl>
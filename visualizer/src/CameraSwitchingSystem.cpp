@@ -15,7 +15,9 @@
 namespace Visualizer {
 
 CameraSwitchingSystem::CameraSwitchingSystem()
-    : m_camera_switcher_query{ EntityDBQuery{}.with_component<ActiveCameraSwitcher>() }
+    : m_tab_pressed{ false }
+    , m_switch_camera{ false }
+    , m_camera_switcher_query{ EntityDBQuery{}.with_component<ActiveCameraSwitcher>() }
     , m_entity_database{}
 {
 }
@@ -24,8 +26,9 @@ void CameraSwitchingSystem::initialize() { m_entity_database = m_world->getManag
 
 void CameraSwitchingSystem::terminate() { m_entity_database = nullptr; }
 
-void CameraSwitchingSystem::run(void*)
+void CameraSwitchingSystem::prepare()
 {
+    m_switch_camera = false;
     if (isDetached()) {
         return;
     }
@@ -33,33 +36,47 @@ void CameraSwitchingSystem::run(void*)
     auto window{ glfwGetCurrentContext() };
     auto tabKey{ glfwGetKey(window, GLFW_KEY_TAB) };
 
-    static bool tabPressed = false;
-
     if (tabKey == GLFW_PRESS) {
-        tabPressed = true;
+        m_tab_pressed = true;
+    }
+
+    if (tabKey == GLFW_RELEASE && m_tab_pressed) {
+        m_tab_pressed = false;
+        m_switch_camera = true;
     }
+}
+
+SystemAccess CameraSwitchingSystem::access() const
+{
+    // The cameras of a switcher may be any entity.
+    SystemAccess access{};
+    access.write<ActiveCameraSwitcher>(m_camera_switcher_query).write<Camera>(EntityDBQuery{});
+    return access;
+}
 
-    if (tabKey == GLFW_RELEASE && tabPressed) {
-        tabPressed = false;
-
-        m_entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
-            m_camera_switcher_query.query_db_window(database_context)
-                .for_each<ActiveCameraSwitcher>([&](ActiveCameraSwitcher* switcher) {
-                    auto current{ switcher->cameras[switcher->current] };
-                    switcher->current++;
-                    if (switcher->current == switcher->cameras.size()) {
-                        switcher->current = 0;
-                    }
-                    auto next{ switcher->cameras[switcher->current] };
-
-                    auto& current_camera{ database_context.fetch_component_unchecked<Camera>(current) };
-                    auto& next_camera{ database_context.fetch_component_unchecked<Camera>(next) };
-
-                    current_camera.m_active = false;
-                    next_camera.m_active = true;
-                });
-        });
+void CameraSwitchingSystem::run(void*)
+{
+    if (!m_switch_camera) {
+        return;
     }
+
+    m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        m_camera_switcher_query.query_db_window(database_context)
+            .for_each<ActiveCameraSwitcher>([&](ActiveCameraSwitcher* switcher) {
+                auto current{ switcher->cameras[switcher->current] };
+                switcher->current++;
+                if (switcher->current == switcher->cameras.size()) {
+                    switcher->current = 0;
+                }
+                auto next{ switcher->cameras[switcher->current] };
+
+                auto& current_camera{ database_context.fetch_component_unchecked<Camera>(current) };
+                auto& next_camera{ database_context.fetch_component_unchecked<Camera>(next) };
+
+                current_camera.m_active = false;
+                next_camera.m_active = true;
+            });
+    });
 }
 
 }
\ No newline at end of file
@@ -16,7 +16,11 @@
 namespace Visualizer {
 
 CameraTypeSwitchingSystem::CameraTypeSwitchingSystem()
-    : m_camera_query{ EntityDBQuery{}.with_component<Camera, FreeFly, FixedCamera>() }
+    : m_f_pressed{ false }
+    , m_g_pressed{ false }
+    , m_toggle_fixed{ false }
+    , m_toggle_perspective{ false }
+    , m_camera_query{ EntityDBQuery{}.with_component<Camera, FreeFly, FixedCamera>() }
     , m_entity_database{}
 {
 }
@@ -25,8 +29,10 @@ void CameraTypeSwitchingSystem::initialize() { m_entity_database = m_world->getM
 
 void CameraTypeSwitchingSystem::terminate() { m_entity_database = nullptr; }
 
-void CameraTypeSwitchingSystem::run(void*)
+void CameraTypeSwitchingSystem::prepare()
 {
+    m_toggle_fixed = false;
+    m_toggle_perspective = false;
     if (isDetached()) {
         return;
     }
@@ -35,29 +41,46 @@ void CameraTypeSwitchingSystem::run(void*)
     auto fKey{ glfwGetKey(window, GLFW_KEY_F) };
     auto gKey{ glfwGetKey(window, GLFW_KEY_G) };
 
-    static bool fPressed = false;
-    static bool gPressed = false;
-
     if (fKey == GLFW_PRESS) {
-        fPressed = true;
+        m_f_pressed = true;
     }
 
     if (gKey == GLFW_PRESS) {
-        gPressed = true;
+        m_g_pressed = true;
+    }
+
+    if (fKey == GLFW_RELEASE && m_f_pressed) {
+        m_f_pressed = false;
+        m_toggle_fixed = true;
     }
 
-    m_entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
-        if (fKey == GLFW_RELEASE && fPressed) {
-            fPressed = false;
+    if (gKey == GLFW_RELEASE && m_g_pressed) {
+        m_g_pressed = false;
+        m_toggle_perspective = true;
+    }
+}
 
+SystemAccess CameraTypeSwitchingSystem::access() const
+{
+    SystemAccess access{};
+    access.write<Camera>(m_camera_query);
+    return access;
+}
+
+void CameraTypeSwitchingSystem::run(void*)
+{
+    if (!m_toggle_fixed && !m_toggle_perspective) {
+        return;
+    }
+
+    m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        if (m_toggle_fixed) {
             m_camera_query.query_db_window(database_context)
                 .filter<Camera>([](const Camera* camera) { return camera->m_active; })
                 .for_each<Camera>([](Camera* camera) { camera->m_fixed = !camera->m_fixed; });
         }
 
-        if (gKey == GLFW_RELEASE && gPressed) {
-            gPressed = false;
-
+        if (m_toggle_perspective) {
             m_camera_query.query_db_window(database_context)
                 .filter<Camera>([](const Camera* camera) { return camera->m_active; })
                 .for_each<Camera>([](Camera* camera) { camera->perspective = !camera->perspective; });
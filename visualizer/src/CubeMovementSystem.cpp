@@ -4,9 +4,7 @@
 
 #include <GLFW/glfw3.h>
 
-#include <visualizer/Iteration.hpp>
-#include <visualizer/Mesh.hpp>
-#include <visualizer/Transform.hpp>
+#include <visualizer/ParallelQuery.hpp>
 
 namespace Visualizer {
 
@@ -15,17 +13,26 @@ CubeMovementSystem::CubeMovementSystem()
     , m_currentTime{ 0 }
     , m_tick_interval{ 1.0 }
     , m_cubes_query_mesh{ EntityDBQuery{}.with_component<MeshIteration, std::shared_ptr<Mesh>>() }
-    , m_cubes_query_activation{ EntityDBQuery{}.with_component<EntityActivation>() }
-    , m_cubes_query_homogeneous{ EntityDBQuery{}.with_component<HomogeneousIteration, Transform>() }
-    , m_cubes_query_heterogeneous{ EntityDBQuery{}.with_component<HeterogeneousIteration, Transform>() }
+    , m_cubes_query_activation{}
+    , m_cubes_query_homogeneous{}
+    , m_cubes_query_heterogeneous{}
+    , m_thread_pool{}
     , m_entity_database{}
 {
     m_currentTime = glfwGetTime();
 }
 
-void CubeMovementSystem::initialize() { m_entity_database = m_world->getManager<EntityDatabase>(); }
+void CubeMovementSystem::initialize()
+{
+    m_thread_pool = m_world->getManager<ThreadPool>();
+    m_entity_database = m_world->getManager<EntityDatabase>();
+}
 
-void CubeMovementSystem::terminate() { m_entity_database = nullptr; }
+void CubeMovementSystem::terminate()
+{
+    m_thread_pool = nullptr;
+    m_entity_database = nullptr;
+}
 
 void reverse_transform(const HomogeneousIteration& iteration, Transform& transform)
 {
@@ -94,7 +101,7 @@ bool step_iteration(MeshIteration& iteration)
     return true;
 }
 
-void step_iteration(EntityActivation& iteration, EntityDatabaseContext& entity_database)
+void step_iteration(EntityActivation& iteration, EntityDatabaseLazyContext& entity_database)
 {
     if (++iteration.tick % iteration.ticksPerIteration[iteration.index] != 0) {
         return;
@@ -105,12 +112,15 @@ void step_iteration(EntityActivation& iteration, EntityDatabaseContext& entity_d
     if (++iteration.index >= iteration.entities.size()) {
         iteration.index = 0;
 
+        // Hiding only flips the enabled bits, the drawing then skips the entities without looking at their layers.
         for (auto entity : iteration.entities) {
-            entity_database.write_component(entity, RenderLayer{ 0 });
+            entity_database.set_component_enabled<RenderLayer>(entity, false);
         }
     }
 
-    entity_database.write_component(iteration.entities[iteration.index], iteration.layer);
+    auto entity{ iteration.entities[iteration.index] };
+    entity_database.write_component(entity, iteration.layer);
+    entity_database.set_component_enabled<RenderLayer>(entity, true);
 }
 
 void step_iteration(HeterogeneousIteration& iteration)
@@ -285,7 +295,7 @@ void compute_mesh(const MeshIteration& iteration, Mesh& mesh)
     mesh.setTextureCoordinates0(tex_coords.data(), tex_coords.size());
 }
 
-void CubeMovementSystem::run(void*)
+void CubeMovementSystem::prepare()
 {
     auto currentTime{ glfwGetTime() };
     auto deltaTime{ currentTime - m_currentTime };
@@ -307,36 +317,55 @@ void CubeMovementSystem::run(void*)
     }
 
     m_accumulator += deltaTime;
+}
+
+SystemAccess CubeMovementSystem::access() const
+{
+    // The meshes are uploaded to OpenGL and the activated entities may be any entity.
+    SystemAccess access{};
+    access.main_thread = true;
+    access.write<MeshIteration>(m_cubes_query_mesh);
+    access.write<std::shared_ptr<Mesh>>(m_cubes_query_mesh);
+    m_cubes_query_activation.declare_access(access);
+    access.write<RenderLayer>(EntityDBQuery{});
+    m_cubes_query_homogeneous.declare_access(access);
+    m_cubes_query_heterogeneous.declare_access(access);
+    return access;
+}
+
+void CubeMovementSystem::run(void*)
+{
     if (m_accumulator >= m_tick_interval) {
         m_accumulator = 0;
 
-        m_entity_database->enter_secure_context([&](EntityDatabaseContext& entity_database) {
-            m_cubes_query_mesh.query_db_window(entity_database)
-                .for_each<MeshIteration, std::shared_ptr<Mesh>>(
-                    [](MeshIteration* meshIteration, std::shared_ptr<Mesh>* mesh) {
-                        if (step_iteration(*meshIteration)) {
-                            compute_mesh(*meshIteration, *mesh->get());
-                        }
-                    });
+        m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& entity_database) {
+            // The mesh handle is a shared component, the mesh itself is still owned by a single entity.
+            auto meshes{ m_cubes_query_mesh.query_db_window(entity_database) };
+            meshes.iterate_chunk<MeshIteration>([&](std::size_t chunk_idx, std::span<MeshIteration> iterations) {
+                const auto& mesh{ *meshes.fetch_chunk_shared_component<std::shared_ptr<Mesh>>(chunk_idx) };
+                for (auto& meshIteration : iterations) {
+                    if (step_iteration(meshIteration)) {
+                        compute_mesh(meshIteration, *mesh);
+                    }
+                }
+            });
 
-            m_cubes_query_activation.query_db_window(entity_database)
-                .for_each<EntityActivation>(
-                    [&](EntityActivation* iteration) { step_iteration(*iteration, entity_database); });
+            m_cubes_query_activation.for_each(
+                entity_database, [&](EntityActivation& iteration) { step_iteration(iteration, entity_database); });
 
-            m_cubes_query_homogeneous.query_db_window(entity_database)
-                .for_each<HomogeneousIteration, Transform>([](HomogeneousIteration* iteration, Transform* transform) {
-                    reverse_transform(*iteration, *transform);
-                    step_iteration(*iteration);
-                    compute_transform(*iteration, *transform);
+            m_cubes_query_homogeneous.for_each_parallel(entity_database, *m_thread_pool,
+                [](HomogeneousIteration& iteration, Transform& transform) {
+                    reverse_transform(iteration, transform);
+                    step_iteration(iteration);
+                    compute_transform(iteration, transform);
                 });
 
-            m_cubes_query_heterogeneous.query_db_window(entity_database)
-                .for_each<HeterogeneousIteration, Transform>(
-                    [](HeterogeneousIteration* iteration, Transform* transform) {
-                        reverse_transform(*iteration, *transform);
-                        step_iteration(*iteration);
-                        compute_transform(*iteration, *transform);
-                    });
+            m_cubes_query_heterogeneous.for_each_parallel(entity_database, *m_thread_pool,
+                [](HeterogeneousIteration& iteration, Transform& transform) {
+                    reverse_transform(iteration, transform);
+                    step_iteration(iteration);
+                    compute_transform(iteration, transform);
+                });
         });
     }
 }
@@ -1,5 +1,6 @@
 #include <visualizer/Entity.hpp>
 
+#include <cassert>
 #include <functional>
 
 namespace Visualizer {
@@ -17,4 +18,63 @@ std::size_t EntityHasher::operator()(const Entity& k) const
 {
     return std::hash<std::size_t>{}(k.id) ^ std::hash<std::size_t>{}(k.generation);
 }
-}
\ No newline at end of file
+
+/**************************************************************************************************
+ ****************************************** EntityRange ******************************************
+ **************************************************************************************************/
+
+EntityRange::Iterator::Iterator(Entity entity)
+    : m_entity{ entity }
+{
+}
+
+Entity EntityRange::Iterator::operator*() const { return m_entity; }
+
+EntityRange::Iterator& EntityRange::Iterator::operator++()
+{
+    ++m_entity.id;
+    return *this;
+}
+
+EntityRange::Iterator EntityRange::Iterator::operator++(int)
+{
+    auto iterator{ *this };
+    ++m_entity.id;
+    return iterator;
+}
+
+bool EntityRange::Iterator::operator==(const Iterator& other) const { return m_entity == other.m_entity; }
+
+EntityRange::EntityRange(Entity first, std::size_t size)
+    : m_first{ first }
+    , m_size{ size }
+{
+}
+
+bool EntityRange::empty() const { return m_size == 0; }
+
+std::size_t EntityRange::size() const { return m_size; }
+
+Entity EntityRange::front() const
+{
+    assert(!empty());
+    return m_first;
+}
+
+Entity EntityRange::back() const
+{
+    assert(!empty());
+    return Entity{ m_first.id + m_size - 1, m_first.generation };
+}
+
+Entity EntityRange::operator[](std::size_t idx) const
+{
+    assert(idx < size());
+    return Entity{ m_first.id + idx, m_first.generation };
+}
+
+EntityRange::Iterator EntityRange::begin() const { return Iterator{ m_first }; }
+
+EntityRange::Iterator EntityRange::end() const { return Iterator{ Entity{ m_first.id + m_size, m_first.generation } }; }
+
+}
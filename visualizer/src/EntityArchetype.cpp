@@ -1,7 +1,26 @@
 #include <visualizer/EntityArchetype.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
 namespace Visualizer {
 
+/**************************************************************************************************
+ ***************************************** ComponentType *****************************************
+ **************************************************************************************************/
+
+void validate_component_type(TypeId component_type) noexcept
+{
+    if (component_type >= MAX_COMPONENT_TYPES) {
+        std::cerr << "ERROR: The component type " << component_type << " exceeds the limit of " << MAX_COMPONENT_TYPES
+                  << " component types!" << std::endl;
+        std::abort();
+    }
+}
+
 /**************************************************************************************************
  ************************************** ComponentDescriptor **************************************
  **************************************************************************************************/
@@ -9,61 +28,149 @@ namespace Visualizer {
 bool ComponentDescriptor::operator==(const ComponentDescriptor& other)
 {
     return (size == other.size && alignment == other.alignment && createFunc == other.createFunc
-        && copyFunc == other.copyFunc && moveFunc == other.moveFunc && destructorFunc == other.destructorFunc);
+        && copyFunc == other.copyFunc && moveFunc == other.moveFunc && destructorFunc == other.destructorFunc
+        && shared == other.shared && tag == other.tag && sparse == other.sparse && enableable == other.enableable
+        && targetFunc == other.targetFunc);
 }
 
 /**************************************************************************************************
- **************************************** EntityArchetype ****************************************
+ *************************************** ComponentSignature ***************************************
  **************************************************************************************************/
 
-EntityArchetype::EntityArchetype(TypeId component_type)
-    : EntityArchetype{ std::span<const TypeId>{ &component_type, 1 } }
+ComponentSignature::ComponentSignature(std::span<const TypeId> component_types)
 {
+    for (auto component_type : component_types) {
+        insert(component_type);
+    }
 }
 
-EntityArchetype::EntityArchetype(std::span<const TypeId> component_types)
-    : m_hash{}
-    , m_identifier{}
-    , m_component_types{}
+bool ComponentSignature::operator<(const ComponentSignature& other) const
 {
-    m_component_types.reserve(component_types.size());
+    return std::lexicographical_compare(m_words.begin(), m_words.end(), other.m_words.begin(), other.m_words.end());
+}
 
-    for (auto component_type : component_types) {
-        auto insertion_pos{ std::upper_bound(m_component_types.begin(), m_component_types.end(), component_type) };
-        if (insertion_pos == m_component_types.end() || *insertion_pos != component_type) {
-            m_component_types.insert(insertion_pos, component_type);
-        }
+bool ComponentSignature::empty() const noexcept
+{
+    return std::all_of(m_words.begin(), m_words.end(), [](std::uint64_t word) { return word == 0; });
+}
+
+std::size_t ComponentSignature::size() const noexcept
+{
+    std::size_t size{ 0 };
+    for (auto word : m_words) {
+        size += std::popcount(word);
     }
+    return size;
+}
+
+std::size_t ComponentSignature::hash() const noexcept
+{
+    // The empty signature hashes to zero.
+    std::size_t hash{ 0 };
+    for (auto word : m_words) {
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+bool ComponentSignature::contains(TypeId component_type) const noexcept
+{
+    return component_type < MAX_COMPONENT_TYPES
+        && (m_words[component_type / WORD_BITS] & (std::uint64_t{ 1 } << (component_type % WORD_BITS))) != 0;
+}
+
+bool ComponentSignature::contains_all(const ComponentSignature& other) const noexcept
+{
+    std::uint64_t missing{ 0 };
+    for (std::size_t i{ 0 }; i < WORD_COUNT; ++i) {
+        missing |= other.m_words[i] & ~m_words[i];
+    }
+    return missing == 0;
+}
+
+bool ComponentSignature::contains_any(const ComponentSignature& other) const noexcept
+{
+    std::uint64_t common{ 0 };
+    for (std::size_t i{ 0 }; i < WORD_COUNT; ++i) {
+        common |= other.m_words[i] & m_words[i];
+    }
+    return common != 0;
+}
 
-    m_identifier.reserve(m_component_types.size() * 20);
+void ComponentSignature::insert(TypeId component_type)
+{
+    validate_component_type(component_type);
+    m_words[component_type / WORD_BITS] |= std::uint64_t{ 1 } << (component_type % WORD_BITS);
+}
+
+void ComponentSignature::erase(TypeId component_type)
+{
+    if (component_type < MAX_COMPONENT_TYPES) {
+        m_words[component_type / WORD_BITS] &= ~(std::uint64_t{ 1 } << (component_type % WORD_BITS));
+    }
+}
 
-    for (auto component_type : m_component_types) {
-        m_identifier.append(std::to_string(component_type));
-        m_identifier.append("|");
+std::vector<TypeId> ComponentSignature::component_types() const
+{
+    std::vector<TypeId> component_types{};
+    component_types.reserve(size());
+    for (std::size_t i{ 0 }; i < WORD_COUNT; ++i) {
+        for (auto word{ m_words[i] }; word != 0; word &= word - 1) {
+            component_types.push_back((i * WORD_BITS) + std::countr_zero(word));
+        }
     }
+    return component_types;
+}
 
-    m_component_types.shrink_to_fit();
-    m_identifier.shrink_to_fit();
+/**************************************************************************************************
+ ************************************ ComponentSignatureHasher ************************************
+ **************************************************************************************************/
+
+std::size_t ComponentSignatureHasher::operator()(const ComponentSignature& k) const { return k.hash(); }
 
-    m_hash = std::hash<std::string>{}(m_identifier);
+/**************************************************************************************************
+ **************************************** EntityArchetype ****************************************
+ **************************************************************************************************/
+
+EntityArchetype::EntityArchetype(TypeId component_type)
+    : EntityArchetype{ std::span<const TypeId>{ &component_type, 1 } }
+{
+}
+
+EntityArchetype::EntityArchetype(std::span<const TypeId> component_types)
+    : EntityArchetype{ ComponentSignature{ component_types } }
+{
+}
+
+EntityArchetype::EntityArchetype(const ComponentSignature& signature)
+    : m_hash{ signature.hash() }
+    , m_signature{ signature }
+    , m_component_types{ signature.component_types() }
+{
 }
 
 bool EntityArchetype::operator==(const EntityArchetype& other) const
 {
-    return m_hash == other.m_hash && m_component_types == other.m_component_types;
+    return m_hash == other.m_hash && m_signature == other.m_signature;
 }
 
 std::size_t EntityArchetype::size() const noexcept { return m_component_types.size(); }
 
 std::size_t EntityArchetype::hash() const noexcept { return m_hash; }
 
-const std::string& EntityArchetype::identifier() const noexcept { return m_identifier; }
+const ComponentSignature& EntityArchetype::signature() const noexcept { return m_signature; }
 
 std::span<const TypeId> EntityArchetype::component_types() const noexcept
 {
     return std::span<const TypeId>{ m_component_types.data(), size() };
 }
 
+bool EntityArchetype::has_component(TypeId component_type) const noexcept
+{
+    return m_signature.contains(component_type);
+}
+
 EntityArchetype EntityArchetype::with(TypeId component_type) const
 {
     return with(std::span<const TypeId>{ &component_type, 1 });
@@ -71,30 +178,11 @@ EntityArchetype EntityArchetype::with(TypeId component_type) const
 
 EntityArchetype EntityArchetype::with(std::span<const TypeId> component_types) const
 {
-    EntityArchetype archetype{};
-    archetype.m_component_types = m_component_types;
-
+    auto signature{ m_signature };
     for (auto component_type : component_types) {
-        auto insertion_pos{ std::upper_bound(
-            archetype.m_component_types.begin(), archetype.m_component_types.end(), component_type) };
-        if (insertion_pos == archetype.m_component_types.end() || *insertion_pos != component_type) {
-            archetype.m_component_types.insert(insertion_pos, component_type);
-        }
+        signature.insert(component_type);
     }
-
-    archetype.m_identifier.reserve(archetype.m_component_types.size() * 20);
-
-    for (auto component_type : archetype.m_component_types) {
-        archetype.m_identifier.append(std::to_string(component_type));
-        archetype.m_identifier.append("|");
-    }
-
-    archetype.m_component_types.shrink_to_fit();
-    archetype.m_identifier.shrink_to_fit();
-
-    archetype.m_hash = std::hash<std::string>{}(archetype.m_identifier);
-
-    return archetype;
+    return EntityArchetype{ signature };
 }
 
 EntityArchetype EntityArchetype::without(TypeId component_type) const
@@ -104,30 +192,11 @@ EntityArchetype EntityArchetype::without(TypeId component_type) const
 
 EntityArchetype EntityArchetype::without(std::span<const TypeId> component_types) const
 {
-    EntityArchetype archetype{};
-    archetype.m_component_types = m_component_types;
-
+    auto signature{ m_signature };
     for (auto component_type : component_types) {
-        auto deletion_pos{ std::upper_bound(
-            archetype.m_component_types.begin(), archetype.m_component_types.end(), component_type) };
-        if (deletion_pos != archetype.m_component_types.end()) {
-            archetype.m_component_types.erase(deletion_pos);
-        }
-    }
-
-    archetype.m_identifier.reserve(archetype.m_component_types.size() * 20);
-
-    for (auto component_type : archetype.m_component_types) {
-        archetype.m_identifier.append(std::to_string(component_type));
-        archetype.m_identifier.append("|");
+        signature.erase(component_type);
     }
-
-    archetype.m_component_types.shrink_to_fit();
-    archetype.m_identifier.shrink_to_fit();
-
-    archetype.m_hash = std::hash<std::string>{}(archetype.m_identifier);
-
-    return archetype;
+    return EntityArchetype{ signature };
 }
 
 /**************************************************************************************************
@@ -0,0 +1,84 @@
+#include <visualizer/EntityBuilder.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace Visualizer {
+
+/**************************************************************************************************
+ ***************************************** EntityBuilder *****************************************
+ **************************************************************************************************/
+
+EntityBuilder::EntityBuilder(const EntityArchetype& archetype)
+    : m_archetype{ archetype }
+    , m_values{}
+{
+}
+
+EntityBuilder::EntityBuilder(EntityBuilder&& other) noexcept
+    : m_archetype{ std::move(other.m_archetype) }
+    , m_values{ std::move(other.m_values) }
+{
+    other.m_values.clear();
+}
+
+EntityBuilder::~EntityBuilder() noexcept { clear(); }
+
+EntityBuilder& EntityBuilder::operator=(EntityBuilder&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        m_archetype = std::move(other.m_archetype);
+        m_values = std::move(other.m_values);
+        other.m_values.clear();
+    }
+    return *this;
+}
+
+const EntityArchetype& EntityBuilder::archetype() const { return m_archetype; }
+
+std::span<const EntityBuilder::ComponentValue> EntityBuilder::values() const
+{
+    return std::span<const ComponentValue>{ m_values.data(), m_values.size() };
+}
+
+bool EntityBuilder::has_value(ComponentType component_type) const
+{
+    return std::any_of(m_values.begin(), m_values.end(),
+        [component_type](const ComponentValue& value) { return value.descriptor.id == component_type; });
+}
+
+EntityBuilder& EntityBuilder::with(ComponentType component_type)
+{
+    if (!m_archetype.has_component(component_type)) {
+        m_archetype = m_archetype.with(component_type);
+    }
+    return *this;
+}
+
+void* EntityBuilder::init_value(const ComponentDescriptor& descriptor)
+{
+    with(descriptor.id);
+
+    auto value_pos{ std::find_if(m_values.begin(), m_values.end(),
+        [&](const ComponentValue& value) { return value.descriptor.id == descriptor.id; }) };
+    if (value_pos != m_values.end()) {
+        value_pos->descriptor.destructorFunc(value_pos->ptr.get());
+        return value_pos->ptr.get();
+    }
+
+    m_values.push_back({ descriptor,
+        std::unique_ptr<std::byte, AlignedDeleter<std::byte>>{
+            AlignedDeleter<std::byte>::allocate(descriptor.alignment, descriptor.size) } });
+    return m_values.back().ptr.get();
+}
+
+void EntityBuilder::clear()
+{
+    for (const auto& value : m_values) {
+        value.descriptor.destructorFunc(value.ptr.get());
+    }
+    m_values.clear();
+}
+
+}
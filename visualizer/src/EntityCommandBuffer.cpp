@@ -0,0 +1,322 @@
+#include <visualizer/EntityCommandBuffer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <visualizer/EntityDatabase.hpp>
+
+namespace Visualizer {
+
+/**************************************************************************************************
+ ************************************** EntityCommandBuffer **************************************
+ **************************************************************************************************/
+
+EntityCommandBuffer::EntityCommandBuffer(EntityCommandBuffer&& other) noexcept
+    : m_mutex{}
+    , m_deferred_entity_count{ std::exchange(other.m_deferred_entity_count, 0) }
+    , m_block_offset{ std::exchange(other.m_block_offset, VALUE_BLOCK_SIZE) }
+    , m_commands{ std::move(other.m_commands) }
+    , m_archetypes{ std::move(other.m_archetypes) }
+    , m_values{ std::move(other.m_values) }
+    , m_value_blocks{ std::move(other.m_value_blocks) }
+{
+    other.m_commands.clear();
+    other.m_archetypes.clear();
+    other.m_values.clear();
+    other.m_value_blocks.clear();
+}
+
+EntityCommandBuffer::~EntityCommandBuffer() noexcept { clear(); }
+
+EntityCommandBuffer& EntityCommandBuffer::operator=(EntityCommandBuffer&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        std::scoped_lock lock{ m_mutex, other.m_mutex };
+        m_deferred_entity_count = std::exchange(other.m_deferred_entity_count, 0);
+        m_block_offset = std::exchange(other.m_block_offset, VALUE_BLOCK_SIZE);
+        m_commands = std::move(other.m_commands);
+        m_archetypes = std::move(other.m_archetypes);
+        m_values = std::move(other.m_values);
+        m_value_blocks = std::move(other.m_value_blocks);
+
+        other.m_commands.clear();
+        other.m_archetypes.clear();
+        other.m_values.clear();
+        other.m_value_blocks.clear();
+    }
+    return *this;
+}
+
+bool EntityCommandBuffer::is_deferred(Entity entity) { return entity.generation == DEFERRED_ENTITY_GENERATION; }
+
+bool EntityCommandBuffer::empty() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_commands.empty();
+}
+
+std::size_t EntityCommandBuffer::size() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_commands.size();
+}
+
+std::size_t EntityCommandBuffer::deferred_entity_count() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_deferred_entity_count;
+}
+
+Entity EntityCommandBuffer::init_entity(const EntityArchetype& archetype)
+{
+    std::scoped_lock lock{ m_mutex };
+    Entity entity{ m_deferred_entity_count++, DEFERRED_ENTITY_GENERATION };
+    m_archetypes.push_back(archetype);
+    record_command(CommandType::InitEntity, entity, 0, m_archetypes.size() - 1);
+    return entity;
+}
+
+void EntityCommandBuffer::erase_entity(Entity entity)
+{
+    std::scoped_lock lock{ m_mutex };
+    record_command(CommandType::EraseEntity, entity, 0, INVALID_IDX);
+}
+
+void EntityCommandBuffer::add_component(Entity entity, ComponentType component_type)
+{
+    std::scoped_lock lock{ m_mutex };
+    record_command(CommandType::AddComponent, entity, component_type, INVALID_IDX);
+}
+
+void EntityCommandBuffer::remove_component(Entity entity, ComponentType component_type)
+{
+    std::scoped_lock lock{ m_mutex };
+    record_command(CommandType::RemoveComponent, entity, component_type, INVALID_IDX);
+}
+
+void EntityCommandBuffer::append(EntityCommandBuffer&& other)
+{
+    assert(this != &other);
+    std::scoped_lock lock{ m_mutex, other.m_mutex };
+
+    m_commands.reserve(m_commands.size() + other.m_commands.size());
+    for (auto command : other.m_commands) {
+        if (is_deferred(command.entity)) {
+            command.entity.id += m_deferred_entity_count;
+        }
+
+        if (command.type == CommandType::InitEntity) {
+            command.data_idx += m_archetypes.size();
+        } else if (command.data_idx != INVALID_IDX) {
+            command.data_idx += m_values.size();
+        }
+        m_commands.push_back(command);
+    }
+
+    m_archetypes.insert(m_archetypes.end(), std::make_move_iterator(other.m_archetypes.begin()),
+        std::make_move_iterator(other.m_archetypes.end()));
+    m_values.insert(m_values.end(), other.m_values.begin(), other.m_values.end());
+
+    // The last block is the one values are currently allocated from.
+    m_value_blocks.insert(m_value_blocks.begin(), std::make_move_iterator(other.m_value_blocks.begin()),
+        std::make_move_iterator(other.m_value_blocks.end()));
+    m_deferred_entity_count += other.m_deferred_entity_count;
+
+    other.m_deferred_entity_count = 0;
+    other.m_block_offset = VALUE_BLOCK_SIZE;
+    other.m_commands.clear();
+    other.m_archetypes.clear();
+    other.m_values.clear();
+    other.m_value_blocks.clear();
+}
+
+std::vector<Entity> EntityCommandBuffer::play_back(EntityDatabaseContext& database_context)
+{
+    struct EntityState {
+        Entity entity;
+        bool erased;
+        std::vector<ComponentType> component_types;
+        std::vector<ComponentType> removed_component_types;
+        /// Values to write after the structural change, `INVALID_IDX` resets the component to its default.
+        std::vector<std::tuple<ComponentType, std::size_t>> writes;
+    };
+
+    std::unique_lock lock{ m_mutex };
+
+    // Collapse the commands into the final state of each entity.
+    std::vector<EntityState> entity_states{};
+    std::unordered_map<Entity, std::size_t, EntityHasher> entity_state_indices{};
+    for (const auto& command : m_commands) {
+        auto [pos, inserted] = entity_state_indices.try_emplace(command.entity, entity_states.size());
+        if (inserted) {
+            assert(is_deferred(command.entity) ? command.type == CommandType::InitEntity
+                                               : database_context.has_entity(command.entity));
+            EntityState entity_state{ command.entity, false, {}, {}, {} };
+            if (!is_deferred(command.entity)) {
+                auto archetype{ database_context.fetch_entity_archetype(command.entity) };
+                auto component_types{ archetype.component_types() };
+                entity_state.component_types = { component_types.begin(), component_types.end() };
+            }
+            entity_states.push_back(std::move(entity_state));
+        }
+
+        auto& entity_state{ entity_states[pos->second] };
+        auto& component_types{ entity_state.component_types };
+        auto& removed_component_types{ entity_state.removed_component_types };
+        auto& writes{ entity_state.writes };
+        assert(!entity_state.erased);
+
+        auto component_pos{ std::lower_bound(component_types.begin(), component_types.end(), command.component_type) };
+        auto has_component{ component_pos != component_types.end() && *component_pos == command.component_type };
+
+        switch (command.type) {
+        case CommandType::InitEntity: {
+            auto archetype_components{ m_archetypes[command.data_idx].component_types() };
+            component_types = { archetype_components.begin(), archetype_components.end() };
+            break;
+        }
+        case CommandType::EraseEntity:
+            entity_state.erased = true;
+            writes.clear();
+            break;
+        case CommandType::AddComponent:
+            if (!has_component) {
+                component_types.insert(component_pos, command.component_type);
+
+                // The component may still exist in the entity, but a removed and re-added component starts anew.
+                if (std::find(removed_component_types.begin(), removed_component_types.end(), command.component_type)
+                    != removed_component_types.end()) {
+                    writes.emplace_back(command.component_type, INVALID_IDX);
+                }
+            }
+            if (command.data_idx != INVALID_IDX) {
+                writes.emplace_back(command.component_type, command.data_idx);
+            }
+            break;
+        case CommandType::RemoveComponent:
+            if (has_component) {
+                component_types.erase(component_pos);
+                removed_component_types.push_back(command.component_type);
+                writes.erase(std::remove_if(writes.begin(), writes.end(),
+                                 [&](const auto& write) { return std::get<0>(write) == command.component_type; }),
+                    writes.end());
+            }
+            break;
+        case CommandType::WriteComponent:
+            assert(has_component);
+            writes.emplace_back(command.component_type, command.data_idx);
+            break;
+        }
+    }
+
+    // Erasing first frees the entity ids and container space for the new entities.
+    for (const auto& entity_state : entity_states) {
+        if (entity_state.erased && !is_deferred(entity_state.entity)) {
+            database_context.erase_entity(entity_state.entity);
+        }
+    }
+
+    std::vector<std::size_t> order{};
+    std::vector<EntityArchetype> archetypes{};
+    archetypes.reserve(entity_states.size());
+    for (std::size_t i{ 0 }; i < entity_states.size(); ++i) {
+        archetypes.emplace_back(std::span<const ComponentType>{ entity_states[i].component_types });
+        if (!entity_states[i].erased) {
+            order.push_back(i);
+        }
+    }
+
+    // Entities with the same destination are applied together, so that each container is visited once.
+    std::stable_sort(order.begin(), order.end(),
+        [&](std::size_t lhs, std::size_t rhs) { return archetypes[lhs].signature() < archetypes[rhs].signature(); });
+
+    std::vector<Entity> created_entities{};
+    created_entities.reserve(m_deferred_entity_count);
+    for (std::size_t i{ 0 }; i < m_deferred_entity_count; ++i) {
+        created_entities.push_back(Entity{ i, DEFERRED_ENTITY_GENERATION });
+    }
+
+    for (auto state_idx : order) {
+        const auto& entity_state{ entity_states[state_idx] };
+        auto entity{ entity_state.entity };
+        if (is_deferred(entity)) {
+            entity = database_context.init_entity(archetypes[state_idx]);
+            created_entities[entity_state.entity.id] = entity;
+        } else {
+            database_context.move_entity(entity, archetypes[state_idx]);
+        }
+
+        for (auto [component_type, value_idx] : entity_state.writes) {
+            const auto& component_desc{ database_context.fetch_component_desc(component_type) };
+            if (value_idx == INVALID_IDX && component_desc.tag) {
+                // Tags have no value, which could be reset.
+                continue;
+            } else if (value_idx == INVALID_IDX && component_desc.shared) {
+                // Shared values are immutable, the entity is moved to the default value instead.
+                auto component{ allocate_value(component_desc.size, component_desc.alignment) };
+                component_desc.createFunc(component);
+                database_context.write_component_move(entity, component_type, component);
+                component_desc.destructorFunc(component);
+            } else if (value_idx == INVALID_IDX) {
+                auto component{ database_context.fetch_component_unchecked(entity, component_type) };
+                component_desc.destructorFunc(component);
+                component_desc.createFunc(component);
+            } else {
+                database_context.write_component_move(entity, component_type, m_values[value_idx].ptr);
+            }
+        }
+    }
+
+    lock.unlock();
+    clear();
+    return created_entities;
+}
+
+void EntityCommandBuffer::clear()
+{
+    std::scoped_lock lock{ m_mutex };
+    for (const auto& value : m_values) {
+        value.descriptor.destructorFunc(value.ptr);
+    }
+
+    m_deferred_entity_count = 0;
+    m_block_offset = VALUE_BLOCK_SIZE;
+    m_commands.clear();
+    m_archetypes.clear();
+    m_values.clear();
+    m_value_blocks.clear();
+}
+
+void* EntityCommandBuffer::allocate_value(std::size_t size, std::size_t alignment)
+{
+    // Values which do not fit into a block receive their own allocation.
+    if (size > VALUE_BLOCK_SIZE || alignment > VALUE_BLOCK_ALIGNMENT) {
+        m_value_blocks.emplace_back(AlignedDeleter<std::byte>::allocate(alignment, size));
+        m_block_offset = VALUE_BLOCK_SIZE;
+        return m_value_blocks.back().get();
+    }
+
+    auto offset{ (m_block_offset + alignment - 1) / alignment * alignment };
+    if (offset + size > VALUE_BLOCK_SIZE) {
+        m_value_blocks.emplace_back(AlignedDeleter<std::byte>::allocate(VALUE_BLOCK_ALIGNMENT, VALUE_BLOCK_SIZE));
+        offset = 0;
+    }
+
+    m_block_offset = offset + size;
+    return m_value_blocks.back().get() + offset;
+}
+
+void EntityCommandBuffer::record_command(
+    CommandType type, Entity entity, ComponentType component_type, std::size_t data_idx)
+{
+    assert(!is_deferred(entity) || entity.id < m_deferred_entity_count);
+    m_commands.push_back(Command{ type, entity, component_type, data_idx });
+}
+
+}
@@ -2,48 +2,268 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
 
 #include <visualizer/EntityDatabase.hpp>
 
 namespace Visualizer {
 
+/**************************************************************************************************
+ **************************************** EntityChunkPool ****************************************
+ **************************************************************************************************/
+
+EntityChunkPool::EntityChunkPool()
+    : EntityChunkPool{ ENTITY_CHUNK_BYTE_BUDGET }
+{
+}
+
+EntityChunkPool::EntityChunkPool(std::size_t block_size)
+    : m_block_size{ block_size }
+    , m_free_blocks{}
+{
+}
+
+bool EntityChunkPool::is_pooled(std::size_t size, std::size_t alignment) const
+{
+    return size <= m_block_size && alignment <= ENTITY_CHUNK_BLOCK_ALIGNMENT;
+}
+
+std::size_t EntityChunkPool::block_size() const { return m_block_size; }
+
+std::size_t EntityChunkPool::free_size() const { return m_free_blocks.size(); }
+
+std::byte* EntityChunkPool::allocate(std::size_t size, std::size_t alignment)
+{
+    if (!is_pooled(size, alignment)) {
+        return AlignedDeleter<std::byte>::allocate(alignment, size);
+    } else if (m_free_blocks.empty()) {
+        return AlignedDeleter<std::byte>::allocate(ENTITY_CHUNK_BLOCK_ALIGNMENT, m_block_size);
+    }
+
+    auto block{ m_free_blocks.back().release() };
+    m_free_blocks.pop_back();
+    return block;
+}
+
+void EntityChunkPool::release(std::byte* block, std::size_t size, std::size_t alignment)
+{
+    assert(block != nullptr);
+    if (!is_pooled(size, alignment)) {
+        AlignedDeleter<std::byte>{}(block);
+    } else {
+        m_free_blocks.emplace_back(block);
+    }
+}
+
+std::size_t EntityChunkPool::trim()
+{
+    auto freed_bytes{ m_free_blocks.size() * m_block_size };
+    m_free_blocks.clear();
+    m_free_blocks.shrink_to_fit();
+    return freed_bytes;
+}
+
+/**************************************************************************************************
+ *************************************** SparseComponentSet ***************************************
+ **************************************************************************************************/
+
+SparseComponentSet::SparseComponentSet(ComponentDescriptor component_desc)
+    : m_component_desc{ component_desc }
+    , m_capacity{ 0 }
+    , m_sparse{}
+    , m_entities{}
+    , m_values{}
+{
+}
+
+SparseComponentSet::~SparseComponentSet()
+{
+    if (!m_component_desc.triviallyDestructible) {
+        for (std::size_t i{ 0 }; i < size(); ++i) {
+            m_component_desc.destructorFunc(m_values.get() + (i * m_component_desc.size));
+        }
+    }
+}
+
+std::size_t SparseComponentSet::size() const { return m_entities.size(); }
+
+bool SparseComponentSet::contains(Entity entity) const
+{
+    return entity.id < m_sparse.size() && m_sparse[entity.id] != INVALID_IDX
+        && m_entities[m_sparse[entity.id]] == entity;
+}
+
+std::span<const Entity> SparseComponentSet::entities() const
+{
+    return std::span<const Entity>{ m_entities.data(), m_entities.size() };
+}
+
+void* SparseComponentSet::init(Entity entity)
+{
+    assert(!contains(entity));
+    if (size() == m_capacity) {
+        reserve(std::max<std::size_t>(m_capacity * 2, 16));
+    }
+    if (entity.id >= m_sparse.size()) {
+        m_sparse.resize(entity.id + 1, INVALID_IDX);
+    }
+
+    auto value{ m_values.get() + (size() * m_component_desc.size) };
+    m_component_desc.createFunc(value);
+    m_sparse[entity.id] = size();
+    m_entities.push_back(entity);
+    return value;
+}
+
+void SparseComponentSet::erase(Entity entity)
+{
+    assert(contains(entity));
+    auto idx{ m_sparse[entity.id] };
+    auto last_idx{ size() - 1 };
+    auto value{ m_values.get() + (idx * m_component_desc.size) };
+    auto last_value{ m_values.get() + (last_idx * m_component_desc.size) };
+
+    if (idx != last_idx) {
+        if (m_component_desc.triviallyCopyable) {
+            std::memcpy(value, last_value, m_component_desc.size);
+        } else {
+            m_component_desc.moveFunc(last_value, value);
+        }
+        m_entities[idx] = m_entities[last_idx];
+        m_sparse[m_entities[idx].id] = idx;
+    }
+
+    if (!m_component_desc.triviallyDestructible) {
+        m_component_desc.destructorFunc(last_value);
+    }
+    m_entities.pop_back();
+    m_sparse[entity.id] = INVALID_IDX;
+}
+
+void* SparseComponentSet::fetch_unchecked(Entity entity)
+{
+    assert(contains(entity));
+    return m_values.get() + (m_sparse[entity.id] * m_component_desc.size);
+}
+
+const void* SparseComponentSet::fetch_unchecked(Entity entity) const
+{
+    assert(contains(entity));
+    return m_values.get() + (m_sparse[entity.id] * m_component_desc.size);
+}
+
+void SparseComponentSet::reserve(std::size_t capacity)
+{
+    assert(capacity > m_capacity);
+    std::unique_ptr<std::byte[], AlignedDeleter<std::byte>> values{ AlignedDeleter<std::byte>::allocate(
+        m_component_desc.alignment, capacity * m_component_desc.size) };
+
+    if (m_component_desc.triviallyCopyable) {
+        if (size() != 0) {
+            std::memcpy(values.get(), m_values.get(), size() * m_component_desc.size);
+        }
+    } else {
+        for (std::size_t i{ 0 }; i < size(); ++i) {
+            auto src{ m_values.get() + (i * m_component_desc.size) };
+            m_component_desc.moveUninitializedFunc(src, values.get() + (i * m_component_desc.size));
+            m_component_desc.destructorFunc(src);
+        }
+    }
+
+    m_values = std::move(values);
+    m_capacity = capacity;
+}
+
 /**************************************************************************************************
  **************************************** ComponentLayout ****************************************
  **************************************************************************************************/
 
-ComponentLayout::ComponentLayout(const EntityArchetype& archetype, const EntityDatabaseImpl& entity_database)
-    : m_archetype{ archetype }
+ComponentLayout::ComponentLayout(
+    const EntityArchetype& archetype, EntityDatabaseImpl& entity_database, std::size_t chunk_byte_budget)
+    : m_chunk_capacity{ 0 }
+    , m_block_size{ 0 }
+    , m_block_alignment{ ENTITY_CHUNK_BLOCK_ALIGNMENT }
+    , m_archetype{ archetype }
     , m_component_descriptors{}
+    , m_component_offsets{}
+    , m_component_indices{}
+    , m_shared_component_types{}
+    , m_global_version{ &entity_database.m_global_version }
+    , m_chunk_pool{ &entity_database.m_chunk_pool }
 {
-    std::vector<TypeId> component_types{};
-    component_types.reserve(archetype.size());
-    m_component_descriptors.reserve(archetype.size());
-
-    for (const auto component_type : archetype.component_types()) {
-        component_types.insert(
-            std::upper_bound(component_types.begin(), component_types.end(), component_type), component_type);
+    // The component types of the archetype are sorted by their type id.
+    auto component_types{ archetype.component_types() };
+    m_component_descriptors.reserve(component_types.size());
+    m_component_offsets.reserve(component_types.size());
+    if (!component_types.empty()) {
+        m_component_indices.resize(component_types.back() + 1, INVALID_COMPONENT_IDX);
     }
 
     for (const auto component_type : component_types) {
-        m_component_descriptors.push_back(entity_database.fetch_component_desc(component_type));
+        const auto& component_desc{ entity_database.fetch_component_desc(component_type) };
+        if (component_desc.tag) {
+            continue;
+        } else if (component_desc.shared) {
+            m_shared_component_types.push_back(component_type);
+        } else {
+            m_component_indices[component_type] = m_component_descriptors.size();
+            m_component_descriptors.push_back(component_desc);
+        }
+    }
+
+    auto entity_size{ sizeof(Entity) };
+    for (const auto& component_desc : m_component_descriptors) {
+        entity_size += component_desc.size;
+        m_block_alignment = std::max(m_block_alignment, component_desc.alignment);
+    }
+
+    // The estimate ignores the padding between the columns, which may require a few less entities.
+    m_chunk_capacity = std::max<std::size_t>(chunk_byte_budget / entity_size, 1);
+    m_block_size = layout_block(m_chunk_capacity);
+    while (m_block_size > chunk_byte_budget && m_chunk_capacity > 1) {
+        m_block_size = layout_block(--m_chunk_capacity);
     }
 }
 
+std::size_t ComponentLayout::layout_block(std::size_t chunk_capacity)
+{
+    // The columns follow the entities, each aligned to its component.
+    auto block_size{ sizeof(Entity) * chunk_capacity };
+    m_component_offsets.clear();
+    for (const auto& component_desc : m_component_descriptors) {
+        auto alignment{ component_desc.alignment };
+        block_size = (block_size + alignment - 1) / alignment * alignment;
+        m_component_offsets.push_back(block_size);
+        block_size += component_desc.size * chunk_capacity;
+    }
+    return block_size;
+}
+
 std::size_t ComponentLayout::size() const { return m_component_descriptors.size(); }
 
+std::size_t ComponentLayout::chunk_capacity() const { return m_chunk_capacity; }
+
+std::size_t ComponentLayout::block_size() const { return m_block_size; }
+
+std::size_t ComponentLayout::block_alignment() const { return m_block_alignment; }
+
+std::size_t ComponentLayout::component_offset(std::size_t idx) const
+{
+    assert(size() > idx);
+    return m_component_offsets[idx];
+}
+
 bool ComponentLayout::has_component(TypeId component_type) const
 {
-    return std::find_if(m_component_descriptors.begin(), m_component_descriptors.end(),
-               [component_type](const ComponentDescriptor& desc) { return desc.id == component_type; })
-        != m_component_descriptors.end();
+    return component_type < m_component_indices.size() && m_component_indices[component_type] != INVALID_COMPONENT_IDX;
 }
 
 std::size_t ComponentLayout::component_idx(TypeId component_type) const
 {
     assert(has_component(component_type));
-    const auto component_pos{ std::find_if(m_component_descriptors.begin(), m_component_descriptors.end(),
-        [component_type](const ComponentDescriptor& desc) { return desc.id == component_type; }) };
-    return std::distance(m_component_descriptors.begin(), component_pos);
+    return m_component_indices[component_type];
 }
 
 ComponentDescriptor ComponentLayout::component_desc(std::size_t idx) const
@@ -57,37 +277,81 @@ std::span<const ComponentDescriptor> ComponentLayout::component_descriptors() co
     return std::span<const ComponentDescriptor>{ m_component_descriptors.data(), size() };
 }
 
+bool ComponentLayout::has_shared_component(TypeId component_type) const
+{
+    return std::binary_search(m_shared_component_types.begin(), m_shared_component_types.end(), component_type);
+}
+
+std::size_t ComponentLayout::shared_component_idx(TypeId component_type) const
+{
+    assert(has_shared_component(component_type));
+    auto component_pos{ std::lower_bound(
+        m_shared_component_types.begin(), m_shared_component_types.end(), component_type) };
+    return std::distance(m_shared_component_types.begin(), component_pos);
+}
+
+std::span<const TypeId> ComponentLayout::shared_component_types() const
+{
+    return std::span<const TypeId>{ m_shared_component_types.data(), m_shared_component_types.size() };
+}
+
 EntityArchetype ComponentLayout::archetype() const { return m_archetype; }
 
+const ComponentSignature& ComponentLayout::signature() const { return m_archetype.signature(); }
+
+const std::atomic<std::size_t>& ComponentLayout::global_version() const { return *m_global_version; }
+
+EntityChunkPool& ComponentLayout::chunk_pool() const { return *m_chunk_pool; }
+
 /**************************************************************************************************
  ***************************************** ComponentChunk *****************************************
  **************************************************************************************************/
 
-ComponentChunk::ComponentChunk(ComponentDescriptor component_data, std::size_t capacity)
+ComponentChunk::ComponentChunk(ComponentDescriptor component_data, std::byte* data, std::size_t capacity,
+    const std::atomic<std::size_t>& global_version)
     : m_size{ 0 }
     , m_capacity{ capacity }
     , m_component_data{ component_data }
-    , m_data{ AlignedDeleter<std::byte>::allocate(component_data.alignment, component_data.size * capacity),
-        AlignedDeleter<std::byte>{} }
+    , m_data{ data }
+    , m_global_version{ &global_version }
+    , m_version{ global_version.load(std::memory_order_relaxed) }
+    , m_enabled_size{ 0 }
+    , m_enabled_words{}
 {
-    assert(m_data.get() != nullptr);
-    assert(reinterpret_cast<std::uintptr_t>(m_data.get()) % component_data.alignment == 0);
+    assert(m_data != nullptr);
+    assert(reinterpret_cast<std::uintptr_t>(m_data) % component_data.alignment == 0);
+    if (component_data.enableable) {
+        m_enabled_words.resize((capacity + ENABLED_WORD_BITS - 1) / ENABLED_WORD_BITS, 0);
+    }
 }
 
-ComponentChunk::~ComponentChunk()
+ComponentChunk::ComponentChunk(ComponentChunk&& other) noexcept
+    : m_size{ std::exchange(other.m_size, 0) }
+    , m_capacity{ std::exchange(other.m_capacity, 0) }
+    , m_component_data{ std::exchange(other.m_component_data, {}) }
+    , m_data{ std::exchange(other.m_data, nullptr) }
+    , m_global_version{ other.m_global_version }
+    , m_version{ other.m_version.load(std::memory_order_relaxed) }
+    , m_enabled_size{ other.m_enabled_size.exchange(0, std::memory_order_relaxed) }
+    , m_enabled_words{ std::exchange(other.m_enabled_words, {}) }
 {
-    while (size() != 0) {
-        erase(size() - 1);
-    }
 }
 
+ComponentChunk::~ComponentChunk() { clear(); }
+
 ComponentChunk& ComponentChunk::operator=(ComponentChunk&& other) noexcept
 {
     if (this != &other) {
+        clear();
+
         m_size = std::exchange(other.m_size, 0);
         m_capacity = std::exchange(other.m_capacity, 0);
         m_component_data = std::exchange(other.m_component_data, {});
-        m_data = std::exchange(other.m_data, {});
+        m_data = std::exchange(other.m_data, nullptr);
+        m_global_version = other.m_global_version;
+        m_version.store(other.m_version.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_enabled_size.store(other.m_enabled_size.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_enabled_words = std::exchange(other.m_enabled_words, {});
     }
 
     return *this;
@@ -97,6 +361,8 @@ std::size_t ComponentChunk::size() const { return m_size; }
 
 std::size_t ComponentChunk::capacity() const { return m_capacity; }
 
+std::size_t ComponentChunk::version() const { return m_version.load(std::memory_order_relaxed); }
+
 std::size_t ComponentChunk::init()
 {
     assert(size() != capacity());
@@ -105,6 +371,19 @@ std::size_t ComponentChunk::init()
     return component_idx;
 }
 
+std::size_t ComponentChunk::init(std::size_t count)
+{
+    assert(size() + count <= capacity());
+    stamp_version();
+    auto component_idx{ m_size };
+    for (std::size_t i{ 0 }; i < count; ++i) {
+        m_component_data.createFunc(m_data + ((component_idx + i) * m_component_data.size));
+    }
+    init_enabled(component_idx, count);
+    m_size += count;
+    return component_idx;
+}
+
 std::size_t ComponentChunk::init_move(void* src)
 {
     assert(size() != capacity());
@@ -125,24 +404,73 @@ void ComponentChunk::erase(std::size_t idx)
 {
     assert(size() > idx);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.destructorFunc(component_ptr);
+    auto last_idx{ size() - 1 };
 
-    // Close the hole by moving all components one place to the front.
-    for (auto next_idx{ idx + 1 }; next_idx != size(); ++next_idx) {
-        auto next_component_ptr{ fetch_unchecked(next_idx) };
-        m_component_data.moveUninitializedFunc(next_component_ptr, component_ptr);
-        component_ptr = next_component_ptr;
+    // Close the hole by moving the last component into it.
+    if (m_component_data.triviallyCopyable) {
+        if (idx != last_idx) {
+            std::memcpy(component_ptr, fetch_unchecked(last_idx), m_component_data.size);
+        }
+    } else {
+        m_component_data.destructorFunc(component_ptr);
+        if (idx != last_idx) {
+            auto last_component_ptr{ fetch_unchecked(last_idx) };
+            m_component_data.moveUninitializedFunc(last_component_ptr, component_ptr);
+            m_component_data.destructorFunc(last_component_ptr);
+        }
     }
 
+    if (enableable()) {
+        assign_enabled(idx, is_enabled(last_idx));
+        assign_enabled(last_idx, false);
+    }
     --m_size;
 }
 
+void ComponentChunk::erase_move(std::size_t idx, ComponentChunk& src)
+{
+    assert(size() > idx);
+    assert(src.size() != 0);
+    assert(this != &src);
+    auto component_ptr{ fetch_unchecked(idx) };
+    auto src_component_ptr{ src.fetch_unchecked(src.size() - 1) };
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(component_ptr, src_component_ptr, m_component_data.size);
+    } else {
+        m_component_data.destructorFunc(component_ptr);
+        m_component_data.moveUninitializedFunc(src_component_ptr, component_ptr);
+        m_component_data.destructorFunc(src_component_ptr);
+    }
+
+    if (enableable()) {
+        assign_enabled(idx, src.is_enabled(src.size() - 1));
+        src.assign_enabled(src.size() - 1, false);
+    }
+    --src.m_size;
+}
+
+void ComponentChunk::clear()
+{
+    if (!m_component_data.triviallyDestructible) {
+        for (std::size_t idx{ 0 }; idx < size(); ++idx) {
+            m_component_data.destructorFunc(m_data + (idx * m_component_data.size));
+        }
+    }
+    std::fill(m_enabled_words.begin(), m_enabled_words.end(), 0);
+    m_enabled_size.store(0, std::memory_order_relaxed);
+    m_size = 0;
+}
+
 void ComponentChunk::read(std::size_t idx, void* dst) const
 {
     assert(size() > idx);
     assert(dst != nullptr);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.copyUninitializedFunc(component_ptr, dst);
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(dst, component_ptr, m_component_data.size);
+    } else {
+        m_component_data.copyFunc(component_ptr, dst);
+    }
 }
 
 void ComponentChunk::write_move(std::size_t idx, void* src)
@@ -150,7 +478,11 @@ void ComponentChunk::write_move(std::size_t idx, void* src)
     assert(size() > idx);
     assert(src != nullptr);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.moveFunc(src, component_ptr);
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(component_ptr, src, m_component_data.size);
+    } else {
+        m_component_data.moveFunc(src, component_ptr);
+    }
 }
 
 void ComponentChunk::write_copy(std::size_t idx, const void* src)
@@ -158,7 +490,11 @@ void ComponentChunk::write_copy(std::size_t idx, const void* src)
     assert(size() > idx);
     assert(src != nullptr);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.copyFunc(src, component_ptr);
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(component_ptr, src, m_component_data.size);
+    } else {
+        m_component_data.copyFunc(src, component_ptr);
+    }
 }
 
 void ComponentChunk::write_uninitialized_init(std::size_t idx)
@@ -173,7 +509,11 @@ void ComponentChunk::write_uninitialized_move(std::size_t idx, void* src)
     assert(size() > idx);
     assert(src != nullptr);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.moveUninitializedFunc(src, component_ptr);
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(component_ptr, src, m_component_data.size);
+    } else {
+        m_component_data.moveUninitializedFunc(src, component_ptr);
+    }
 }
 
 void ComponentChunk::write_uninitialized_copy(std::size_t idx, const void* src)
@@ -181,51 +521,136 @@ void ComponentChunk::write_uninitialized_copy(std::size_t idx, const void* src)
     assert(size() > idx);
     assert(src != nullptr);
     auto component_ptr{ fetch_unchecked(idx) };
-    m_component_data.copyUninitializedFunc(src, component_ptr);
+    if (m_component_data.triviallyCopyable) {
+        std::memcpy(component_ptr, src, m_component_data.size);
+    } else {
+        m_component_data.copyUninitializedFunc(src, component_ptr);
+    }
 }
 
 void* ComponentChunk::fetch_unchecked(std::size_t idx)
 {
     assert(size() > idx);
-    return static_cast<void*>(m_data.get() + (idx * m_component_data.size));
+    stamp_version();
+    return static_cast<void*>(m_data + (idx * m_component_data.size));
 }
 
 const void* ComponentChunk::fetch_unchecked(std::size_t idx) const
 {
     assert(size() > idx);
-    return static_cast<const void*>(m_data.get() + (idx * m_component_data.size));
+    return static_cast<const void*>(m_data + (idx * m_component_data.size));
+}
+
+bool ComponentChunk::enableable() const { return m_component_data.enableable; }
+
+bool ComponentChunk::is_enabled(std::size_t idx) const
+{
+    assert(enableable());
+    assert(size() > idx);
+    std::atomic_ref<const std::uint64_t> word{ m_enabled_words[idx / ENABLED_WORD_BITS] };
+    return (word.load(std::memory_order_relaxed) >> (idx % ENABLED_WORD_BITS)) & 1;
+}
+
+void ComponentChunk::set_enabled(std::size_t idx, bool enabled)
+{
+    assert(enableable());
+    assert(size() > idx);
+    stamp_version();
+    assign_enabled(idx, enabled);
 }
 
+std::size_t ComponentChunk::enabled_size() const { return m_enabled_size.load(std::memory_order_relaxed); }
+
+std::span<const std::uint64_t> ComponentChunk::enabled_words() const { return m_enabled_words; }
+
 std::size_t ComponentChunk::phantom_init()
 {
     assert(size() != capacity());
+    stamp_version();
+    init_enabled(m_size, 1);
     return m_size++;
 }
 
+void ComponentChunk::stamp_version()
+{
+    // Avoid writing to the shared cache line, when the column was already stamped by the running system.
+    auto global_version{ m_global_version->load(std::memory_order_relaxed) };
+    if (m_version.load(std::memory_order_relaxed) != global_version) {
+        m_version.store(global_version, std::memory_order_relaxed);
+    }
+}
+
+void ComponentChunk::init_enabled(std::size_t idx, std::size_t count)
+{
+    if (!enableable()) {
+        return;
+    }
+
+    for (auto i{ idx }; i < idx + count; ++i) {
+        m_enabled_words[i / ENABLED_WORD_BITS] |= std::uint64_t{ 1 } << (i % ENABLED_WORD_BITS);
+    }
+    m_enabled_size.fetch_add(count, std::memory_order_relaxed);
+}
+
+void ComponentChunk::assign_enabled(std::size_t idx, bool enabled)
+{
+    // Lazy contexts may toggle the bits of neighbouring entities concurrently, which share the word and the counter.
+    std::atomic_ref<std::uint64_t> word{ m_enabled_words[idx / ENABLED_WORD_BITS] };
+    auto bit{ std::uint64_t{ 1 } << (idx % ENABLED_WORD_BITS) };
+    auto previous{ enabled ? word.fetch_or(bit, std::memory_order_relaxed)
+                           : word.fetch_and(~bit, std::memory_order_relaxed) };
+    if (static_cast<bool>(previous & bit) == enabled) {
+        return;
+    } else if (enabled) {
+        m_enabled_size.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_enabled_size.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
 /**************************************************************************************************
  ****************************************** EntityChunk ******************************************
  **************************************************************************************************/
 
 EntityChunk::EntityChunk(const ComponentLayout& layout)
     : m_size{ 0 }
+    , m_capacity{ layout.chunk_capacity() }
     , m_layout{ layout }
+    , m_block{ layout.chunk_pool().allocate(layout.block_size(), layout.block_alignment()) }
+    , m_entities{ reinterpret_cast<Entity*>(m_block) }
     , m_component_chunks{}
-    , m_entities{}
 {
+    assert(m_block != nullptr);
     m_component_chunks.reserve(layout.size());
 
-    for (auto component : layout.component_descriptors()) {
-        m_component_chunks.emplace_back(component, capacity());
+    for (std::size_t component_idx{ 0 }; component_idx < layout.size(); ++component_idx) {
+        m_component_chunks.emplace_back(layout.component_desc(component_idx),
+            m_block + layout.component_offset(component_idx), m_capacity, layout.global_version());
     }
 }
 
+EntityChunk::EntityChunk(EntityChunk&& other) noexcept
+    : m_size{ std::exchange(other.m_size, 0) }
+    , m_capacity{ std::exchange(other.m_capacity, 0) }
+    , m_layout{ other.m_layout }
+    , m_block{ std::exchange(other.m_block, nullptr) }
+    , m_entities{ std::exchange(other.m_entities, nullptr) }
+    , m_component_chunks{ std::exchange(other.m_component_chunks, {}) }
+{
+}
+
+EntityChunk::~EntityChunk() { release(); }
+
 EntityChunk& EntityChunk::operator=(EntityChunk&& other) noexcept
 {
     if (this != &other) {
+        release();
         m_size = std::exchange(other.m_size, 0);
-        std::swap(m_layout, other.m_layout);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_layout = other.m_layout;
+        m_block = std::exchange(other.m_block, nullptr);
+        m_entities = std::exchange(other.m_entities, nullptr);
         m_component_chunks = std::exchange(other.m_component_chunks, {});
-        m_entities = std::exchange(other.m_entities, {});
     }
 
     return *this;
@@ -233,24 +658,12 @@ EntityChunk& EntityChunk::operator=(EntityChunk&& other) noexcept
 
 std::size_t EntityChunk::size() const { return m_size; }
 
-std::size_t EntityChunk::capacity() const { return ENTITY_CHUNK_SIZE; }
+std::size_t EntityChunk::capacity() const { return m_capacity; }
 
 std::size_t EntityChunk::component_size() const { return m_layout.get().size(); }
 
-bool EntityChunk::has_entity(Entity entity) const
-{
-    return std::find(m_entities.begin(), m_entities.begin() + size(), entity) != m_entities.begin() + size();
-}
-
 bool EntityChunk::has_component(TypeId component_type) const { return m_layout.get().has_component(component_type); }
 
-std::size_t EntityChunk::entity_idx(Entity entity) const
-{
-    assert(has_entity(entity));
-    const auto entity_pos{ std::find(m_entities.begin(), m_entities.begin() + size(), entity) };
-    return std::distance(m_entities.begin(), entity_pos);
-}
-
 std::size_t EntityChunk::component_idx(TypeId component_type) const
 {
     assert(has_component(component_type));
@@ -259,7 +672,6 @@ std::size_t EntityChunk::component_idx(TypeId component_type) const
 
 std::size_t EntityChunk::init(Entity entity)
 {
-    assert(!has_entity(entity));
     auto entity_idx{ phantom_init(entity) };
     for (auto& component_chunk : m_component_chunks) {
         component_chunk.init();
@@ -267,14 +679,22 @@ std::size_t EntityChunk::init(Entity entity)
     return entity_idx;
 }
 
-std::size_t EntityChunk::init_move(Entity entity, EntityContainer& entity_container, EntityLocation entity_location)
+std::size_t EntityChunk::init(EntityRange entities)
 {
-    assert(!has_entity(entity));
+    assert(size() + entities.size() <= capacity());
+    auto entity_idx{ size() };
+    std::uninitialized_copy(entities.begin(), entities.end(), m_entities + entity_idx);
+    m_size += entities.size();
+    for (auto& component_chunk : m_component_chunks) {
+        component_chunk.init(entities.size());
+    }
+    return entity_idx;
+}
 
+std::size_t EntityChunk::init_move(Entity entity, EntityContainer& entity_container, EntityLocation entity_location)
+{
     auto entity_idx{ phantom_init(entity) };
 
-    auto& foreign_entity_chunk{ entity_container.entity_chunk(entity_location.chunk_idx) };
-
     for (std::size_t component_idx{ 0 }; component_idx < m_layout.get().size(); ++component_idx) {
         auto component_type{ m_layout.get().component_desc(component_idx).id };
 
@@ -282,27 +702,20 @@ std::size_t EntityChunk::init_move(Entity entity, EntityContainer& entity_contai
             auto foreign_component_idx{ entity_container.component_idx(component_type) };
             auto foreign_component_ptr{ entity_container.fetch_unchecked(entity_location, foreign_component_idx) };
 
-            // Move the component.
+            // Move the component, the moved-from object is destroyed once the entity is erased from the container.
             m_component_chunks[component_idx].init_move(foreign_component_ptr);
-
-            // Reinitialize the component to allow destructor calls.
-            foreign_entity_chunk.m_component_chunks[foreign_component_idx].write_uninitialized_init(
-                entity_location.entity_idx);
+            copy_enabled(entity_idx, component_idx, entity_container, entity_location, foreign_component_idx);
         } else {
             m_component_chunks[component_idx].init();
         }
     }
 
-    entity_container.erase(entity_location);
-
     return entity_idx;
 }
 
 std::size_t EntityChunk::init_copy(
     Entity entity, const EntityContainer& entity_container, EntityLocation entity_location)
 {
-    assert(!has_entity(entity));
-
     auto entity_idx{ phantom_init(entity) };
 
     for (std::size_t component_idx{ 0 }; component_idx < m_layout.get().size(); ++component_idx) {
@@ -314,6 +727,7 @@ std::size_t EntityChunk::init_copy(
 
             // Copy the component.
             m_component_chunks[component_idx].init_copy(foreign_component_ptr);
+            copy_enabled(entity_idx, component_idx, entity_container, entity_location, foreign_component_idx);
         } else {
             m_component_chunks[component_idx].init();
         }
@@ -330,8 +744,20 @@ void EntityChunk::erase(std::size_t entity_idx)
         component_chunk.erase(entity_idx);
     }
 
-    std::move(m_entities.begin() + entity_idx + 1, m_entities.begin() + size(), m_entities.begin() + entity_idx);
-    --m_size;
+    m_entities[entity_idx] = m_entities[--m_size];
+}
+
+void EntityChunk::erase_move(std::size_t entity_idx, EntityChunk& src)
+{
+    assert(size() > entity_idx);
+    assert(src.size() != 0);
+    assert(&m_layout.get() == &src.m_layout.get());
+
+    for (std::size_t component_idx{ 0 }; component_idx < m_component_chunks.size(); ++component_idx) {
+        m_component_chunks[component_idx].erase_move(entity_idx, src.m_component_chunks[component_idx]);
+    }
+
+    m_entities[entity_idx] = src.m_entities[--src.m_size];
 }
 
 void EntityChunk::read(std::size_t entity_idx, std::size_t component_idx, void* dst) const
@@ -372,72 +798,161 @@ const void* EntityChunk::fetch_unchecked(std::size_t entity_idx, std::size_t com
     return m_component_chunks[component_idx].fetch_unchecked(entity_idx);
 }
 
-std::span<const Entity> EntityChunk::entities() const { return std::span<const Entity>{ m_entities.begin(), size() }; }
+ComponentChunk& EntityChunk::component_chunk(std::size_t component_idx)
+{
+    assert(component_size() > component_idx);
+    return m_component_chunks[component_idx];
+}
+
+const ComponentChunk& EntityChunk::component_chunk(std::size_t component_idx) const
+{
+    assert(component_size() > component_idx);
+    return m_component_chunks[component_idx];
+}
+
+std::span<const Entity> EntityChunk::entities() const
+{
+    return std::span<const Entity>{ m_entities, m_size };
+}
 
 EntityArchetype EntityChunk::archetype() const { return m_layout.get().archetype(); }
 
+void EntityChunk::copy_enabled(std::size_t entity_idx, std::size_t component_idx,
+    const EntityContainer& entity_container, EntityLocation entity_location, std::size_t foreign_component_idx)
+{
+    auto& component_chunk{ m_component_chunks[component_idx] };
+    if (component_chunk.enableable()) {
+        const auto& foreign_chunk{ entity_container.entity_chunk(entity_location.chunk_idx) };
+        component_chunk.set_enabled(entity_idx,
+            foreign_chunk.component_chunk(foreign_component_idx).is_enabled(entity_location.entity_idx));
+    }
+}
+
 std::size_t EntityChunk::phantom_init(Entity entity)
 {
-    assert(!has_entity(entity));
-    m_entities[size()] = entity;
+    assert(size() != capacity());
+    new (m_entities + m_size) Entity{ entity };
     return m_size++;
 }
 
+void EntityChunk::release()
+{
+    // The components must be destroyed before their memory is returned to the pool.
+    m_component_chunks.clear();
+    if (m_block != nullptr) {
+        const auto& layout{ m_layout.get() };
+        layout.chunk_pool().release(m_block, layout.block_size(), layout.block_alignment());
+        m_block = nullptr;
+        m_entities = nullptr;
+        m_size = 0;
+    }
+}
+
 /**************************************************************************************************
  **************************************** EntityContainer ****************************************
  **************************************************************************************************/
 
-EntityContainer::EntityContainer(const EntityArchetype& archetype, const EntityDatabaseImpl& entity_database)
+EntityContainer::EntityContainer(const EntityArchetype& archetype, EntityDatabaseImpl& entity_database,
+    std::size_t chunk_byte_budget, std::span<const SharedValueId> shared_value_ids)
     : m_size{ 0 }
-    , m_capacity{ ENTITY_CHUNK_SIZE }
-    , m_empty_chunks{ 1 }
-    , m_filled_chunks{ 0 }
-    , m_layout{ archetype, entity_database }
+    , m_layout{ archetype, entity_database, chunk_byte_budget }
+    , m_chunk_capacity{ m_layout.chunk_capacity() }
     , m_entity_chunks{}
-    , m_capacity_map{}
-    , m_entity_map{}
+    , m_shared_value_ids{ shared_value_ids.begin(), shared_value_ids.end() }
+    , m_shared_values{}
+    , m_add_edges{}
+    , m_remove_edges{}
 {
+    // Containers without explicit values store the default values of their shared components.
+    auto shared_component_types{ m_layout.shared_component_types() };
+    if (m_shared_value_ids.empty()) {
+        m_shared_value_ids.resize(shared_component_types.size(), DEFAULT_SHARED_VALUE_ID);
+    }
+    assert(m_shared_value_ids.size() == shared_component_types.size());
+
+    m_shared_values.reserve(shared_component_types.size());
+    for (std::size_t i{ 0 }; i < shared_component_types.size(); ++i) {
+        m_shared_values.push_back(
+            entity_database.fetch_shared_component_value(shared_component_types[i], m_shared_value_ids[i]));
+    }
+
     m_entity_chunks.emplace_back(m_layout);
-    m_capacity_map.push_back({ 0, ENTITY_CHUNK_SIZE });
-    m_entity_map.reserve(ENTITY_CHUNK_SIZE);
 }
 
 std::size_t EntityContainer::size() const { return m_size; }
 
-std::size_t EntityContainer::capacity() const { return m_capacity; }
+std::size_t EntityContainer::capacity() const { return m_entity_chunks.size() * m_chunk_capacity; }
+
+std::size_t EntityContainer::chunk_capacity() const { return m_chunk_capacity; }
 
 std::size_t EntityContainer::component_size() const { return m_layout.size(); }
 
-bool EntityContainer::has_entity(Entity entity) const { return m_entity_map.contains(entity); }
+bool EntityContainer::has_component(TypeId component_type) const { return signature().contains(component_type); }
 
-bool EntityContainer::has_component(TypeId component_type) const { return m_layout.has_component(component_type); }
+std::size_t EntityContainer::component_idx(TypeId component_type) const
+{
+    return m_layout.component_idx(component_type);
+}
 
-EntityLocation EntityContainer::entity_location(Entity entity) const
+bool EntityContainer::has_shared_component(TypeId component_type) const
 {
-    assert(has_entity(entity));
-    auto chunk_idx{ m_entity_map.at(entity) };
-    auto entity_idx{ m_entity_chunks[chunk_idx].entity_idx(entity) };
-    return EntityLocation{ chunk_idx, entity_idx };
+    return m_layout.has_shared_component(component_type);
 }
 
-std::size_t EntityContainer::component_idx(TypeId component_type) const
+SharedValueId EntityContainer::shared_value_id(TypeId component_type) const
 {
-    return m_layout.component_idx(component_type);
+    return m_shared_value_ids[m_layout.shared_component_idx(component_type)];
+}
+
+std::span<const TypeId> EntityContainer::shared_component_types() const { return m_layout.shared_component_types(); }
+
+std::span<const SharedValueId> EntityContainer::shared_value_ids() const
+{
+    return std::span<const SharedValueId>{ m_shared_value_ids.data(), m_shared_value_ids.size() };
+}
+
+const void* EntityContainer::fetch_shared_unchecked(TypeId component_type) const
+{
+    return m_shared_values[m_layout.shared_component_idx(component_type)];
 }
 
 EntityLocation EntityContainer::init(Entity entity)
 {
-    assert(!has_entity(entity));
-    auto chunk_idx{ phantom_init(entity) };
+    auto chunk_idx{ phantom_init() };
     auto entity_idx{ m_entity_chunks[chunk_idx].init(entity) };
     return EntityLocation{ chunk_idx, entity_idx };
 }
 
+EntityLocation EntityContainer::init(EntityRange entities)
+{
+    if (entities.empty()) {
+        return EntityLocation{ m_size / m_chunk_capacity, m_size % m_chunk_capacity };
+    }
+
+    auto required_chunks{ (m_size + entities.size() + m_chunk_capacity - 1) / m_chunk_capacity };
+    m_entity_chunks.reserve(required_chunks);
+    while (m_entity_chunks.size() < required_chunks) {
+        m_entity_chunks.emplace_back(m_layout);
+    }
+
+    EntityLocation entity_location{ m_size / m_chunk_capacity, m_size % m_chunk_capacity };
+    std::size_t initialized{ 0 };
+    for (auto chunk_idx{ entity_location.chunk_idx }; initialized != entities.size(); ++chunk_idx) {
+        auto& entity_chunk{ m_entity_chunks[chunk_idx] };
+        auto count{ std::min(entity_chunk.capacity() - entity_chunk.size(), entities.size() - initialized) };
+        entity_chunk.init(EntityRange{ entities[initialized], count });
+        initialized += count;
+    }
+
+    m_size += entities.size();
+    return entity_location;
+}
+
 EntityLocation EntityContainer::init_move(
     Entity entity, EntityContainer& entity_container, EntityLocation entity_location)
 {
-    assert(!has_entity(entity));
-    auto chunk_idx{ phantom_init(entity) };
+    assert(this != &entity_container);
+    auto chunk_idx{ phantom_init() };
     auto entity_idx{ m_entity_chunks[chunk_idx].init_move(entity, entity_container, entity_location) };
     return EntityLocation{ chunk_idx, entity_idx };
 }
@@ -445,73 +960,51 @@ EntityLocation EntityContainer::init_move(
 EntityLocation EntityContainer::init_copy(
     Entity entity, const EntityContainer& entity_container, EntityLocation entity_location)
 {
-    assert(!has_entity(entity));
-    auto chunk_idx{ phantom_init(entity) };
+    auto chunk_idx{ phantom_init() };
     auto entity_idx{ m_entity_chunks[chunk_idx].init_copy(entity, entity_container, entity_location) };
     return EntityLocation{ chunk_idx, entity_idx };
 }
 
-void EntityContainer::erase(EntityLocation entity_location)
+std::optional<Entity> EntityContainer::erase(EntityLocation entity_location)
 {
     assert(m_entity_chunks.size() > entity_location.chunk_idx);
-    auto removed_entity{ m_entity_chunks[entity_location.chunk_idx].entities()[entity_location.entity_idx] };
-    m_entity_chunks[entity_location.chunk_idx].erase(entity_location.chunk_idx);
-    m_entity_map.erase(removed_entity);
-    m_size--;
-
-    auto chunk_capacity{ ChunkCapacity{ entity_location.chunk_idx,
-        m_entity_chunks[entity_location.chunk_idx].capacity() - m_entity_chunks[entity_location.chunk_idx].size() } };
+    assert(m_entity_chunks[entity_location.chunk_idx].size() > entity_location.entity_idx);
 
-    auto original_capacity_map_pos{ std::lower_bound(m_capacity_map.begin() + m_filled_chunks, m_capacity_map.end(),
-        chunk_capacity, [](const ChunkCapacity& capacity, const ChunkCapacity& value) {
-            if (capacity.chunk_capacity < value.chunk_capacity - 1) {
-                return true;
-            } else {
-                return capacity.chunk_idx < value.chunk_idx;
-            }
-        }) };
+    auto& entity_chunk{ m_entity_chunks[entity_location.chunk_idx] };
+    auto removed_entity{ entity_chunk.entities()[entity_location.entity_idx] };
+    auto last_chunk_idx{ (m_size - 1) / m_chunk_capacity };
+    auto& last_entity_chunk{ m_entity_chunks[last_chunk_idx] };
+    auto last_entity{ last_entity_chunk.entities().back() };
 
-    if (m_entity_chunks.size() == 1) {
-        *original_capacity_map_pos = chunk_capacity;
+    if (entity_location.chunk_idx == last_chunk_idx) {
+        entity_chunk.erase(entity_location.entity_idx);
     } else {
-        auto capacity_map_pos{ std::lower_bound(m_capacity_map.begin() + m_filled_chunks, m_capacity_map.end(),
-            chunk_capacity, [](const ChunkCapacity& capacity, const ChunkCapacity& value) {
-                if (capacity.chunk_capacity < value.chunk_capacity) {
-                    return true;
-                } else {
-                    return capacity.chunk_idx < value.chunk_idx;
-                }
-            }) };
-
-        if (capacity_map_pos == original_capacity_map_pos) {
-            *original_capacity_map_pos = chunk_capacity;
-        } else {
-            auto new_idx{ std::distance(m_capacity_map.begin(), capacity_map_pos) - 1 };
-            m_capacity_map.erase(original_capacity_map_pos);
-            m_capacity_map.insert(m_capacity_map.begin() + new_idx, chunk_capacity);
-        }
+        entity_chunk.erase_move(entity_location.entity_idx, last_entity_chunk);
     }
 
-    if (chunk_capacity.chunk_capacity == ENTITY_CHUNK_SIZE) {
-        if (++m_empty_chunks > ENTITY_CHUNK_ALLOCATION_BUFFER) {
-            const auto chunk_to_remove{ m_capacity_map.back() };
-
-            for (auto i = chunk_to_remove.chunk_idx + 1; i < m_entity_chunks.size(); ++i) {
-                auto chunk_entities{ m_entity_chunks[i].entities() };
+    m_size--;
 
-                for (auto entity : chunk_entities) {
-                    m_entity_map.find(entity)->second--;
-                }
-            }
+    // Keep a few empty chunks around, to avoid reallocations when the size fluctuates.
+    auto required_chunks{ std::max<std::size_t>((m_size + m_chunk_capacity - 1) / m_chunk_capacity, 1) };
+    if (m_entity_chunks.size() > required_chunks + ENTITY_CHUNK_ALLOCATION_BUFFER) {
+        m_entity_chunks.pop_back();
+    }
 
-            m_entity_chunks.erase(m_entity_chunks.begin() + chunk_to_remove.chunk_idx);
-            m_capacity_map.erase(m_capacity_map.end() - 1);
-        }
-    } else if (chunk_capacity.chunk_capacity == 1) {
-        m_filled_chunks--;
+    if (last_entity == removed_entity) {
+        return std::nullopt;
+    } else {
+        return last_entity;
     }
 }
 
+std::size_t EntityContainer::shrink_to_fit()
+{
+    auto required_chunks{ (m_size + m_chunk_capacity - 1) / m_chunk_capacity };
+    auto released_chunks{ m_entity_chunks.size() - required_chunks };
+    m_entity_chunks.erase(m_entity_chunks.begin() + required_chunks, m_entity_chunks.end());
+    return released_chunks;
+}
+
 void EntityContainer::read(EntityLocation entity_location, std::size_t component_idx, void* dst) const
 {
     assert(m_entity_chunks.size() > entity_location.chunk_idx);
@@ -559,6 +1052,10 @@ const EntityChunk& EntityContainer::entity_chunk(std::size_t chunk_idx) const
 
 EntityArchetype EntityContainer::archetype() const { return m_layout.archetype(); }
 
+const ComponentSignature& EntityContainer::signature() const { return m_layout.signature(); }
+
+const ComponentLayout& EntityContainer::layout() const { return m_layout; }
+
 std::span<EntityChunk> EntityContainer::entity_chunks()
 {
     return std::span<EntityChunk>{ m_entity_chunks.data(), m_entity_chunks.size() };
@@ -569,48 +1066,47 @@ std::span<const EntityChunk> EntityContainer::entity_chunks() const
     return std::span<const EntityChunk>{ m_entity_chunks.data(), m_entity_chunks.size() };
 }
 
-std::size_t EntityContainer::phantom_init(Entity entity)
+std::optional<std::size_t> EntityContainer::fetch_add_edge(TypeId component_type) const
 {
-    assert(!has_entity(entity));
-    m_size++;
-    if (size() <= capacity()) {
-        auto suitable_chunk_pos{ m_capacity_map.begin() + m_filled_chunks };
-        auto chunk{ *suitable_chunk_pos };
-        chunk.chunk_capacity--;
+    if (component_type < m_add_edges.size() && m_add_edges[component_type] != INVALID_EDGE) {
+        return m_add_edges[component_type];
+    }
+    return std::nullopt;
+}
 
-        auto new_chunk_pos{ std::lower_bound(m_capacity_map.begin() + m_filled_chunks, m_capacity_map.end(), chunk,
-            [](const ChunkCapacity& capacity, const ChunkCapacity& value) {
-                if (capacity.chunk_capacity < value.chunk_capacity) {
-                    return true;
-                } else {
-                    return capacity.chunk_idx < value.chunk_idx;
-                }
-            }) };
+std::optional<std::size_t> EntityContainer::fetch_remove_edge(TypeId component_type) const
+{
+    if (component_type < m_remove_edges.size() && m_remove_edges[component_type] != INVALID_EDGE) {
+        return m_remove_edges[component_type];
+    }
+    return std::nullopt;
+}
 
-        if (suitable_chunk_pos == new_chunk_pos) {
-            *suitable_chunk_pos = chunk;
-        } else {
-            m_capacity_map.erase(suitable_chunk_pos);
-            m_capacity_map.insert(new_chunk_pos, chunk);
-        }
+void EntityContainer::insert_add_edge(TypeId component_type, std::size_t container_id)
+{
+    assert(!fetch_add_edge(component_type));
+    if (component_type >= m_add_edges.size()) {
+        m_add_edges.resize(component_type + 1, INVALID_EDGE);
+    }
+    m_add_edges[component_type] = container_id;
+}
 
-        if (chunk.chunk_capacity == ENTITY_CHUNK_SIZE - 1) {
-            m_empty_chunks--;
-        } else if (chunk.chunk_capacity == 0) {
-            m_filled_chunks++;
-        }
+void EntityContainer::insert_remove_edge(TypeId component_type, std::size_t container_id)
+{
+    assert(!fetch_remove_edge(component_type));
+    if (component_type >= m_remove_edges.size()) {
+        m_remove_edges.resize(component_type + 1, INVALID_EDGE);
+    }
+    m_remove_edges[component_type] = container_id;
+}
 
-        m_entity_map.insert({ entity, chunk.chunk_idx });
-        return chunk.chunk_idx;
-    } else {
-        const auto chunk_idx{ m_entity_chunks.size() };
+std::size_t EntityContainer::phantom_init()
+{
+    auto chunk_idx{ m_size++ / m_chunk_capacity };
+    if (chunk_idx == m_entity_chunks.size()) {
         m_entity_chunks.emplace_back(m_layout);
-        m_capacity_map.push_back(ChunkCapacity{ chunk_idx, ENTITY_CHUNK_SIZE - 1 });
-        m_capacity += ENTITY_CHUNK_SIZE;
-
-        m_entity_map.insert({ entity, chunk_idx });
-        return chunk_idx;
     }
+    return chunk_idx;
 }
 
-}
\ No newline at end of file
+}
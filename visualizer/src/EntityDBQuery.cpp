@@ -2,8 +2,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <utility>
 
+#include <visualizer/EntityContainer.hpp>
 #include <visualizer/EntityDatabase.hpp>
+#include <visualizer/ThreadPool.hpp>
 
 namespace Visualizer {
 
@@ -15,6 +19,11 @@ EntityDBQuery::EntityDBQuery(const EntityArchetype& archetype)
     : m_required_components{}
     , m_prohibited_components{}
     , m_optional_components{}
+    , m_required_signature{ archetype.signature() }
+    , m_prohibited_signature{}
+    , m_optional_signature{}
+    , m_registered_database{ nullptr }
+    , m_registered_id{ 0 }
 {
     auto archetype_components{ archetype.component_types() };
     m_required_components = { archetype_components.begin(), archetype_components.end() };
@@ -22,6 +31,8 @@ EntityDBQuery::EntityDBQuery(const EntityArchetype& archetype)
 
 EntityDBQuery& EntityDBQuery::with_component(ComponentType component_type)
 {
+    m_registered_database = nullptr;
+
     auto required_pos{ std::lower_bound(m_required_components.begin(), m_required_components.end(), component_type) };
     auto prohibited_pos{ std::lower_bound(
         m_prohibited_components.begin(), m_prohibited_components.end(), component_type) };
@@ -39,11 +50,17 @@ EntityDBQuery& EntityDBQuery::with_component(ComponentType component_type)
         m_optional_components.erase(optional_pos);
     }
 
+    m_required_signature.insert(component_type);
+    m_prohibited_signature.erase(component_type);
+    m_optional_signature.erase(component_type);
+
     return *this;
 }
 
 EntityDBQuery& EntityDBQuery::without_component(ComponentType component_type)
 {
+    m_registered_database = nullptr;
+
     auto required_pos{ std::lower_bound(m_required_components.begin(), m_required_components.end(), component_type) };
     auto prohibited_pos{ std::lower_bound(
         m_prohibited_components.begin(), m_prohibited_components.end(), component_type) };
@@ -61,11 +78,17 @@ EntityDBQuery& EntityDBQuery::without_component(ComponentType component_type)
         m_optional_components.erase(optional_pos);
     }
 
+    m_required_signature.erase(component_type);
+    m_prohibited_signature.insert(component_type);
+    m_optional_signature.erase(component_type);
+
     return *this;
 }
 
 EntityDBQuery& EntityDBQuery::with_optional_component(ComponentType component_type)
 {
+    m_registered_database = nullptr;
+
     auto required_pos{ std::lower_bound(m_required_components.begin(), m_required_components.end(), component_type) };
     auto prohibited_pos{ std::lower_bound(
         m_prohibited_components.begin(), m_prohibited_components.end(), component_type) };
@@ -83,6 +106,10 @@ EntityDBQuery& EntityDBQuery::with_optional_component(ComponentType component_ty
         m_optional_components.insert(optional_pos, component_type);
     }
 
+    m_required_signature.erase(component_type);
+    m_prohibited_signature.erase(component_type);
+    m_optional_signature.insert(component_type);
+
     return *this;
 }
 
@@ -125,54 +152,93 @@ std::span<const ComponentType> EntityDBQuery::optional_components() const
     return std::span<const ComponentType>{ m_optional_components.data(), m_optional_components.size() };
 }
 
+bool EntityDBQuery::matches(const EntityArchetype& archetype) const { return matches(archetype.signature()); }
+
+bool EntityDBQuery::matches(const ComponentSignature& signature) const
+{
+    return signature.contains_all(m_required_signature) && !signature.contains_any(m_prohibited_signature);
+}
+
+bool EntityDBQuery::matches(const EntityDBQuery& other) const
+{
+    return m_required_signature == other.m_required_signature
+        && m_prohibited_signature == other.m_prohibited_signature
+        && m_optional_signature == other.m_optional_signature;
+}
+
 EntityDBWindow EntityDBQuery::query_db_window(EntityDatabaseContext& database_context)
 {
     return database_context.query_db_window(*this);
 }
 
+EntityDBWindow EntityDBQuery::query_db_window(EntityDatabaseLazyContext& database_context)
+{
+    return database_context.query_db_window(*this);
+}
+
 /**************************************************************************************************
  ***************************************** EntityDBWindow *****************************************
  **************************************************************************************************/
 
-EntityDBWindow::EntityDBWindow(std::vector<Entity>&& entities, std::vector<std::vector<void*>>&& components,
-    std::unordered_map<ComponentType, std::size_t>&& component_type_map)
-    : m_entities{ std::move(entities) }
+EntityDBWindow::EntityDBWindow(const EntityDatabaseImpl* database, std::vector<EntityDBWindowChunk>&& chunks,
+    std::vector<ComponentChunk*>&& components, std::vector<ComponentType>&& component_types,
+    std::vector<std::size_t>&& component_sizes)
+    : m_size{ 0 }
+    , m_database{ database }
+    , m_chunks{ std::move(chunks) }
+    , m_container_ranges{}
     , m_components{ std::move(components) }
-    , m_component_type_map{ std::move(component_type_map) }
-    , m_entity_index_map{}
+    , m_component_types{ std::move(component_types) }
+    , m_component_sizes{ std::move(component_sizes) }
+    , m_sparse_sets{}
+    , m_tag_values{}
 {
-    assert(m_components.size() == m_component_type_map.size());
-    for (const auto& component_vec : m_components) {
-        assert(component_vec.size() == m_entities.size());
+    assert(m_component_types.size() == m_component_sizes.size());
+    m_sparse_sets.reserve(m_component_types.size());
+    m_tag_values.reserve(m_component_types.size());
+    for (auto component_type : m_component_types) {
+        m_sparse_sets.push_back(
+            m_database != nullptr ? m_database->fetch_sparse_component_set(component_type) : nullptr);
+        m_tag_values.push_back(m_database != nullptr ? m_database->fetch_tag_value(component_type) : nullptr);
     }
 
-    m_entity_index_map.reserve(m_entities.size());
-    for (std::size_t i{ 0 }; i < m_entities.size(); ++i) {
-        m_entity_index_map.insert({ m_entities[i], i });
+    assert(m_components.size() == m_chunks.size() * m_component_types.size());
+    for (std::size_t chunk_idx{ 0 }; chunk_idx < m_chunks.size(); ++chunk_idx) {
+        const auto& chunk{ m_chunks[chunk_idx] };
+        assert(chunk.entity_offset == m_size);
+        m_size += chunk.entities.size();
+
+        if (m_container_ranges.empty() || m_container_ranges.back().container != chunk.container) {
+            m_container_ranges.push_back({ chunk.container, chunk_idx, chunk_idx });
+        }
+        m_container_ranges.back().last_chunk = chunk_idx + 1;
     }
 }
 
-std::size_t EntityDBWindow::size() const { return m_entities.size(); }
+std::size_t EntityDBWindow::size() const { return m_size; }
 
-std::size_t EntityDBWindow::component_size() const { return m_components.size(); }
+std::size_t EntityDBWindow::chunk_size() const { return m_chunks.size(); }
+
+std::size_t EntityDBWindow::component_size() const { return m_component_types.size(); }
 
 std::size_t EntityDBWindow::entity_idx(Entity entity) const
 {
     assert(has_entity(entity));
-    return m_entity_index_map.at(entity);
+    return find_entity(entity).value_or(size());
 }
 
 std::size_t EntityDBWindow::component_idx(ComponentType component_type) const
 {
     assert(has_component(component_type));
-    return m_component_type_map.at(component_type);
+    auto component_pos{ std::find(m_component_types.begin(), m_component_types.end(), component_type) };
+    return std::distance(m_component_types.begin(), component_pos);
 }
 
-bool EntityDBWindow::has_entity(Entity entity) const { return m_entity_index_map.contains(entity); }
+bool EntityDBWindow::has_entity(Entity entity) const { return find_entity(entity).has_value(); }
 
 bool EntityDBWindow::has_component(ComponentType component_type) const
 {
-    return m_component_type_map.contains(component_type);
+    return std::find(m_component_types.begin(), m_component_types.end(), component_type) != m_component_types.end();
 }
 
 bool EntityDBWindow::entity_has_component(Entity entity, ComponentType component_type) const
@@ -180,40 +246,194 @@ bool EntityDBWindow::entity_has_component(Entity entity, ComponentType component
     assert(has_entity(entity));
     assert(has_component(component_type));
 
-    const auto entity_index{ entity_idx(entity) };
-    const auto component_index{ component_idx(component_type) };
-    return fetch_component_unchecked(entity_index, component_index) != nullptr;
+    if (const auto* sparse_set{ m_sparse_sets[component_idx(component_type)] }) {
+        return sparse_set->contains(entity);
+    }
+    return m_chunks[chunk_idx(entity_idx(entity))].container->signature().contains(component_type);
+}
+
+bool EntityDBWindow::has_column(std::size_t component_idx) const
+{
+    assert(component_idx < component_size());
+    return m_database == nullptr || m_database->has_column(m_component_types[component_idx]);
 }
 
 void* EntityDBWindow::fetch_component_unchecked(std::size_t entity_idx, std::size_t component_idx)
 {
-    assert(entity_idx < m_entities.size());
-    assert(component_idx < m_components.size());
-    return m_components[component_idx][entity_idx];
+    assert(!is_shared(component_idx));
+    return const_cast<void*>(std::as_const(*this).fetch_component_unchecked(entity_idx, component_idx));
 }
 
 const void* EntityDBWindow::fetch_component_unchecked(std::size_t entity_idx, std::size_t component_idx) const
 {
-    assert(entity_idx < m_entities.size());
-    assert(component_idx < m_components.size());
-    return m_components[component_idx][entity_idx];
+    assert(entity_idx < size());
+    assert(component_idx < component_size());
+    auto chunk_index{ chunk_idx(entity_idx) };
+    const auto& chunk{ m_chunks[chunk_index] };
+    if (auto sparse_set{ m_sparse_sets[component_idx] }) {
+        return fetch_sparse_component(*sparse_set, chunk.entities[entity_idx - chunk.entity_offset]);
+    } else if (!has_column(component_idx)) {
+        return fetch_chunk_value(chunk_index, component_idx);
+    }
+
+    auto column{ static_cast<const std::byte*>(fetch_chunk_component_unchecked(chunk_index, component_idx)) };
+    if (column == nullptr) {
+        return nullptr;
+    }
+    return column + (entity_idx - chunk.entity_offset) * m_component_sizes[component_idx];
+}
+
+void* EntityDBWindow::fetch_chunk_component_unchecked(std::size_t chunk_idx, std::size_t component_idx)
+{
+    assert(chunk_idx < chunk_size());
+    assert(component_idx < component_size());
+    const auto& chunk{ m_chunks[chunk_idx] };
+    auto component_chunk{ m_components[chunk.component_offset + component_idx] };
+    return component_chunk != nullptr ? component_chunk->fetch_unchecked(chunk.chunk_entity_idx) : nullptr;
+}
+
+const void* EntityDBWindow::fetch_chunk_component_unchecked(std::size_t chunk_idx, std::size_t component_idx) const
+{
+    assert(chunk_idx < chunk_size());
+    assert(component_idx < component_size());
+    const auto& chunk{ m_chunks[chunk_idx] };
+    const ComponentChunk* component_chunk{ m_components[chunk.component_offset + component_idx] };
+    return component_chunk != nullptr ? component_chunk->fetch_unchecked(chunk.chunk_entity_idx) : nullptr;
+}
+
+std::span<const Entity> EntityDBWindow::chunk_entities(std::size_t chunk_idx) const
+{
+    assert(chunk_idx < chunk_size());
+    return m_chunks[chunk_idx].entities;
 }
 
-std::span<const Entity> EntityDBWindow::entity_span() const
+const void* EntityDBWindow::fetch_chunk_shared_component_unchecked(
+    std::size_t chunk_idx, ComponentType component_type) const
 {
-    return std::span<const Entity>{ m_entities.data(), m_entities.size() };
+    assert(chunk_idx < chunk_size());
+    const auto& entity_container{ *m_chunks[chunk_idx].container };
+    if (!entity_container.has_shared_component(component_type)) {
+        return nullptr;
+    }
+    return entity_container.fetch_shared_unchecked(component_type);
+}
+
+std::size_t EntityDBWindow::chunk_version(std::size_t chunk_idx, std::size_t component_idx) const
+{
+    assert(chunk_idx < chunk_size());
+    assert(component_idx < component_size());
+    const ComponentChunk* component_chunk{ m_components[m_chunks[chunk_idx].component_offset + component_idx] };
+    return component_chunk != nullptr ? component_chunk->version() : 0;
+}
+
+EntityDBWindow EntityDBWindow::changed_since(std::size_t version, std::span<const ComponentType> component_types) const
+{
+    std::vector<std::size_t> component_indices{};
+    component_indices.reserve(component_types.size());
+    for (auto component_type : component_types) {
+        component_indices.push_back(component_idx(component_type));
+    }
+
+    std::vector<EntityDBWindowChunk> chunks{};
+    std::vector<ComponentChunk*> components{};
+    std::size_t entity_offset{ 0 };
+    for (std::size_t chunk_idx{ 0 }; chunk_idx < chunk_size(); ++chunk_idx) {
+        if (std::none_of(component_indices.begin(), component_indices.end(),
+                [&](std::size_t component_idx) { return chunk_version(chunk_idx, component_idx) > version; })) {
+            continue;
+        }
+
+        const auto& chunk{ m_chunks[chunk_idx] };
+        chunks.push_back({ chunk.entities, entity_offset, components.size(), chunk.chunk_entity_idx,
+            chunk.container_chunk_idx, chunk.container });
+        components.insert(components.end(), m_components.begin() + chunk.component_offset,
+            m_components.begin() + chunk.component_offset + component_size());
+        entity_offset += chunk.entities.size();
+    }
+
+    return EntityDBWindow{ m_database, std::move(chunks), std::move(components),
+        std::vector<ComponentType>{ m_component_types }, std::vector<std::size_t>{ m_component_sizes } };
+}
+
+std::size_t EntityDBWindow::chunk_idx(std::size_t entity_idx) const
+{
+    assert(entity_idx < size());
+    auto chunk_pos{ std::upper_bound(m_chunks.begin(), m_chunks.end(), entity_idx,
+        [](std::size_t idx, const EntityDBWindowChunk& chunk) { return idx < chunk.entity_offset; }) };
+    return std::distance(m_chunks.begin(), chunk_pos) - 1;
 }
 
-std::span<void*> EntityDBWindow::component_span(std::size_t component_idx)
+void* EntityDBWindow::fetch_sparse_component(SparseComponentSet& sparse_set, Entity entity)
 {
-    assert(component_idx < m_components.size());
-    return std::span<void*>{ m_components[component_idx].data(), m_components[component_idx].size() };
+    return sparse_set.contains(entity) ? sparse_set.fetch_unchecked(entity) : nullptr;
+}
+
+const void* EntityDBWindow::fetch_chunk_value(std::size_t chunk_idx, std::size_t component_idx) const
+{
+    assert(chunk_idx < chunk_size());
+    assert(component_idx < component_size());
+    const auto& entity_container{ *m_chunks[chunk_idx].container };
+    auto component_type{ m_component_types[component_idx] };
+    if (!entity_container.signature().contains(component_type)) {
+        return nullptr;
+    } else if (m_tag_values[component_idx] != nullptr) {
+        return m_tag_values[component_idx];
+    }
+    return fetch_chunk_shared_component_unchecked(chunk_idx, component_type);
 }
 
-std::span<void* const> EntityDBWindow::component_span(std::size_t component_idx) const
+bool EntityDBWindow::is_shared(std::size_t component_idx) const
 {
-    assert(component_idx < m_components.size());
-    return std::span<void* const>{ m_components[component_idx].data(), m_components[component_idx].size() };
+    return !has_column(component_idx) && m_sparse_sets[component_idx] == nullptr
+        && m_tag_values[component_idx] == nullptr;
 }
 
-}
\ No newline at end of file
+std::optional<std::size_t> EntityDBWindow::find_entity(Entity entity) const
+{
+    if (m_database == nullptr || !m_database->has_entity(entity)) {
+        return std::nullopt;
+    }
+
+    const auto* entity_container{ &m_database->fetch_entity_container(entity) };
+    auto container_pos{ std::find_if(m_container_ranges.begin(), m_container_ranges.end(),
+        [&](const ContainerRange& range) { return range.container == entity_container; }) };
+    if (container_pos == m_container_ranges.end()) {
+        return std::nullopt;
+    }
+
+    // The runs of a container are ordered by their chunk and their first entity, the last run starting at or before
+    // the location is the only one which may contain the entity.
+    auto entity_location{ m_database->fetch_entity_location(entity) };
+    auto first_chunk{ m_chunks.begin() + container_pos->first_chunk };
+    auto last_chunk{ m_chunks.begin() + container_pos->last_chunk };
+    auto chunk_pos{ std::upper_bound(first_chunk, last_chunk, entity_location,
+        [](const EntityLocation& location, const EntityDBWindowChunk& chunk) {
+            return location.chunk_idx < chunk.container_chunk_idx
+                || (location.chunk_idx == chunk.container_chunk_idx && location.entity_idx < chunk.chunk_entity_idx);
+        }) };
+    if (chunk_pos == first_chunk) {
+        return std::nullopt;
+    }
+
+    const auto& chunk{ *std::prev(chunk_pos) };
+    if (chunk.container_chunk_idx != entity_location.chunk_idx
+        || entity_location.entity_idx >= chunk.chunk_entity_idx + chunk.entities.size()) {
+        return std::nullopt;
+    }
+    return chunk.entity_offset + (entity_location.entity_idx - chunk.chunk_entity_idx);
+}
+
+std::size_t EntityDBWindow::parallel_task_count(const ThreadPool& thread_pool) const
+{
+    // A few tasks per thread allow the pool to balance chunks of uneven cost.
+    constexpr std::size_t tasks_per_thread{ 4 };
+    return std::min(chunk_size(), (thread_pool.worker_count() + 1) * tasks_per_thread);
+}
+
+std::size_t EntityDBWindow::parallel_task_first_chunk(std::size_t task_idx, std::size_t task_count) const
+{
+    assert(task_idx <= task_count);
+    return task_idx * chunk_size() / task_count;
+}
+
+}
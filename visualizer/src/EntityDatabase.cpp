@@ -1,143 +1,418 @@
 #include <visualizer/EntityDatabase.hpp>
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
 
 namespace Visualizer {
 
+namespace {
+
+/// Orders the entities by their id and generation, so that duplicates are adjacent.
+bool entity_less(Entity lhs, Entity rhs)
+{
+    return lhs.id < rhs.id || (lhs.id == rhs.id && lhs.generation < rhs.generation);
+}
+
+/// Index of the first bit at or after `idx`, which has the value `bit`, or the number of bits of the mask.
+std::size_t find_mask_bit(std::span<const std::uint64_t> mask, std::size_t idx, bool bit)
+{
+    constexpr auto word_bits{ ComponentChunk::ENABLED_WORD_BITS };
+    for (auto word_idx{ idx / word_bits }; word_idx < mask.size(); ++word_idx) {
+        auto word{ bit ? mask[word_idx] : ~mask[word_idx] };
+        if (word_idx == idx / word_bits) {
+            word &= ~std::uint64_t{ 0 } << (idx % word_bits);
+        }
+        if (word != 0) {
+            return word_idx * word_bits + std::countr_zero(word);
+        }
+    }
+    return mask.size() * word_bits;
+}
+
+}
+
+/**************************************************************************************************
+ *********************************** EntityCompactionStatistics ***********************************
+ **************************************************************************************************/
+
+double EntityCompactionStatistics::fill_ratio() const
+{
+    if (entity_capacity == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(entity_count) / static_cast<double>(entity_capacity);
+}
+
+/**************************************************************************************************
+ *************************************** EntityObservation ****************************************
+ **************************************************************************************************/
+
+bool EntityObservation::empty() const { return added.empty() && removed.empty() && written.empty(); }
+
+/**************************************************************************************************
+ **************************************** RelatedEntities *****************************************
+ **************************************************************************************************/
+
+RelatedEntities::RelatedEntities(std::shared_ptr<const RelationSnapshot> snapshot, std::span<const Entity> entities)
+    : m_snapshot{ std::move(snapshot) }
+    , m_entities{ entities }
+{
+}
+
+std::size_t RelatedEntities::size() const { return m_entities.size(); }
+
+bool RelatedEntities::empty() const { return m_entities.empty(); }
+
+Entity RelatedEntities::operator[](std::size_t idx) const
+{
+    assert(idx < size());
+    return m_entities[idx];
+}
+
+std::span<const Entity>::iterator RelatedEntities::begin() const { return m_entities.begin(); }
+
+std::span<const Entity>::iterator RelatedEntities::end() const { return m_entities.end(); }
+
+std::span<const Entity> RelatedEntities::entities() const { return m_entities; }
+
 /**************************************************************************************************
  *************************************** EntityDatabaseImpl ***************************************
  **************************************************************************************************/
 
-bool EntityDatabaseImpl::has_entity(Entity entity) const { return m_entities.contains(entity); }
+EntityDatabaseImpl::EntityDatabaseImpl(std::size_t chunk_byte_budget)
+    : m_chunk_byte_budget{ chunk_byte_budget }
+    , m_chunk_pool{ chunk_byte_budget }
+{
+}
+
+EntityDatabaseImpl::~EntityDatabaseImpl() noexcept
+{
+    for (ComponentType component_type{ 0 }; component_type < m_shared_component_values.size(); ++component_type) {
+        for (const auto& value : m_shared_component_values[component_type]) {
+            fetch_component_desc(component_type).destructorFunc(value.get());
+        }
+    }
+}
+
+bool EntityDatabaseImpl::has_entity(Entity entity) const
+{
+    return entity.id < m_entity_slots.size() && m_entity_slots[entity.id].generation == entity.generation
+        && m_entity_slots[entity.id].container_id != INVALID_CONTAINER_ID;
+}
 
 bool EntityDatabaseImpl::has_component(ComponentType component_type) const
 {
-    return m_component_descriptors.contains(component_type);
+    return component_type < m_component_descriptors.size() && m_component_descriptors[component_type].has_value();
 }
 
 bool EntityDatabaseImpl::entity_has_component(Entity entity, ComponentType component_type) const
 {
     assert(has_entity(entity));
     assert(has_component(component_type));
+    if (m_sparse_components.contains(component_type)) {
+        return m_sparse_component_sets[component_type]->contains(entity);
+    }
     return fetch_entity_container(entity).has_component(component_type);
 }
 
 ComponentType EntityDatabaseImpl::register_component_desc(
     ComponentType component_type, ComponentDescriptor component_desc)
 {
+    validate_component_type(component_type);
     assert(!has_component(component_type));
-    auto [pos, success] = m_component_descriptors.insert({ component_type, component_desc });
-    assert(success);
+    if (component_type >= m_component_descriptors.size()) {
+        m_component_descriptors.resize(component_type + 1);
+    }
+    m_component_descriptors[component_type] = component_desc;
+
+    if (component_desc.targetFunc != nullptr) {
+        assert(!component_desc.shared && !component_desc.sparse);
+        if (component_type >= m_relation_indices.size()) {
+            m_relation_indices.resize(component_type + 1);
+        }
+        m_relation_components.insert(component_type);
+        m_relation_indices[component_type] = std::make_unique<RelationIndex>();
+    }
+
+    // The default value of a shared component is stored first, so that its id is `DEFAULT_SHARED_VALUE_ID`.
+    if (component_desc.shared) {
+        assert(component_desc.equalFunc != nullptr);
+        assert(!component_desc.enableable);
+        m_shared_components.insert(component_type);
+        component_desc.createFunc(allocate_shared_value(component_type));
+    } else if (component_desc.sparse) {
+        assert(!component_desc.enableable);
+        if (component_type >= m_sparse_component_sets.size()) {
+            m_sparse_component_sets.resize(component_type + 1);
+        }
+        m_sparse_components.insert(component_type);
+        m_sparse_component_sets[component_type] = std::make_unique<SparseComponentSet>(component_desc);
+    } else if (component_desc.tag) {
+        m_tag_components.insert(component_type);
+        component_desc.createFunc(allocate_shared_value(component_type));
+    }
     return component_type;
 }
 
 const ComponentDescriptor& EntityDatabaseImpl::fetch_component_desc(ComponentType component_type) const
 {
     assert(has_component(component_type));
-    return m_component_descriptors.at(component_type);
+    return *m_component_descriptors[component_type];
+}
+
+const void* EntityDatabaseImpl::fetch_shared_component_value(ComponentType component_type, SharedValueId value_id) const
+{
+    assert(m_shared_components.contains(component_type));
+    assert(m_shared_component_values[component_type].size() > value_id);
+    return m_shared_component_values[component_type][value_id].get();
 }
 
 Entity EntityDatabaseImpl::init_entity(const EntityArchetype& archetype)
 {
-    for (auto component_type : archetype.component_types()) {
-        assert(has_component(component_type));
-    }
-    auto entity{ generate_new_entity() };
-    auto& entity_container{ fetch_or_init_entity_container(archetype) };
-    m_entities.emplace(entity, m_archetype_map.at(archetype));
-    entity_container.init(entity);
+    assert(has_components(archetype));
+    auto entity_archetype{ container_archetype(archetype) };
+    auto entity{ init_entity(
+        fetch_or_init_entity_container(entity_archetype, shared_value_ids(entity_archetype, nullptr))) };
+    move_sparse_components(entity, archetype);
     return entity;
 }
 
 Entity EntityDatabaseImpl::init_entity(EntityBuilder&& entity_builder)
 {
-    /// TODO: Implement move parameterised entity initialisation
-    assert(false);
-    (void)entity_builder;
-    return Entity();
+    assert(has_components(entity_builder.archetype()));
+    auto shared_value_ids{ fetch_or_init_shared_value_ids(entity_builder) };
+    auto entity{ init_entity(
+        fetch_or_init_entity_container(container_archetype(entity_builder.archetype()), shared_value_ids)) };
+    move_sparse_components(entity, entity_builder.archetype());
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    for (const auto& value : entity_builder.values()) {
+        if (has_column(value.descriptor.id)) {
+            auto component_idx{ entity_container.component_idx(value.descriptor.id) };
+            entity_container.write_move(entity_slot.location, component_idx, value.ptr.get());
+        } else if (m_sparse_components.contains(value.descriptor.id)) {
+            write_component_move(entity, value.descriptor.id, value.ptr.get());
+        }
+    }
+    return entity;
 }
 
 Entity EntityDatabaseImpl::init_entity(const EntityBuilder& entity_builder)
 {
-    /// TODO: Implement parameterised entity initialisation
-    assert(false);
-    (void)entity_builder;
-    return Entity();
+    assert(has_components(entity_builder.archetype()));
+    auto shared_value_ids{ fetch_or_init_shared_value_ids(entity_builder) };
+    auto entity{ init_entity(
+        fetch_or_init_entity_container(container_archetype(entity_builder.archetype()), shared_value_ids)) };
+    move_sparse_components(entity, entity_builder.archetype());
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    for (const auto& value : entity_builder.values()) {
+        if (has_column(value.descriptor.id)) {
+            auto component_idx{ entity_container.component_idx(value.descriptor.id) };
+            entity_container.write_copy(entity_slot.location, component_idx, value.ptr.get());
+        } else if (m_sparse_components.contains(value.descriptor.id)) {
+            write_component_copy(entity, value.descriptor.id, value.ptr.get());
+        }
+    }
+    return entity;
+}
+
+EntityRange EntityDatabaseImpl::init_entities(const EntityArchetype& archetype, std::size_t count)
+{
+    assert(has_components(archetype));
+    auto entity_archetype{ container_archetype(archetype) };
+    auto entities{ init_entities(
+        fetch_or_init_entity_container(entity_archetype, shared_value_ids(entity_archetype, nullptr)), count) };
+    if (entity_archetype.size() != archetype.size()) {
+        for (auto entity : entities) {
+            move_sparse_components(entity, archetype);
+        }
+    }
+    return entities;
+}
+
+EntityRange EntityDatabaseImpl::init_entities(EntityContainerId container_id, std::size_t count)
+{
+    if (count == 0) {
+        return EntityRange{};
+    }
+
+    // Free ids are not reused, so that the ids of the range are consecutive.
+    EntityRange entities{ Entity{ m_entity_slots.size(), 0 }, count };
+    auto& entity_container{ *m_entity_containers[container_id] };
+    auto entity_location{ entity_container.init(entities) };
+
+    m_entity_slots.reserve(m_entity_slots.size() + count);
+    for (std::size_t i{ 0 }; i < count; ++i) {
+        m_entity_slots.push_back(EntitySlot{ 0, container_id, entity_location });
+        if (++entity_location.entity_idx == entity_container.chunk_capacity()) {
+            entity_location.chunk_idx++;
+            entity_location.entity_idx = 0;
+        }
+    }
+    invalidate_relation_indices(container_id);
+    if (entity_container.signature().contains_any(m_observed_components)) {
+        for (auto entity : entities) {
+            observe_signature_change(entity, ComponentSignature{}, entity_container.signature());
+        }
+    }
+
+    return entities;
+}
+
+EntityRange EntityDatabaseImpl::init_entities(const EntityBuilder& entity_builder, std::size_t count)
+{
+    assert(has_components(entity_builder.archetype()));
+    if (count == 0) {
+        return EntityRange{};
+    }
+
+    auto shared_value_ids{ fetch_or_init_shared_value_ids(entity_builder) };
+    auto entity_archetype{ container_archetype(entity_builder.archetype()) };
+    auto entities{ init_entities(fetch_or_init_entity_container(entity_archetype, shared_value_ids), count) };
+    if (entity_archetype.size() != entity_builder.archetype().size()) {
+        for (auto entity : entities) {
+            move_sparse_components(entity, entity_builder.archetype());
+        }
+    }
+
+    // Write the values column by column, the shared values are already stored in the container.
+    auto window{ query_db_window(entities) };
+    for (const auto& value : entity_builder.values()) {
+        if (m_sparse_components.contains(value.descriptor.id)) {
+            for (auto entity : entities) {
+                write_component_copy(entity, value.descriptor.id, value.ptr.get());
+            }
+            continue;
+        } else if (!has_column(value.descriptor.id)) {
+            continue;
+        }
+
+        auto component_idx{ window.component_idx(value.descriptor.id) };
+        for (std::size_t chunk_idx{ 0 }; chunk_idx < window.chunk_size(); ++chunk_idx) {
+            auto column{ static_cast<std::byte*>(window.fetch_chunk_component_unchecked(chunk_idx, component_idx)) };
+            auto column_size{ window.chunk_entities(chunk_idx).size() };
+            if (value.descriptor.triviallyCopyable && column_size != 0) {
+                // Fill the column by doubling the already written prefix.
+                std::memcpy(column, value.ptr.get(), value.descriptor.size);
+                for (std::size_t written{ 1 }; written < column_size; written *= 2) {
+                    auto count{ std::min(written, column_size - written) };
+                    std::memcpy(column + (written * value.descriptor.size), column, count * value.descriptor.size);
+                }
+            } else {
+                for (std::size_t i{ 0 }; i < column_size; ++i) {
+                    value.descriptor.copyFunc(value.ptr.get(), column + (i * value.descriptor.size));
+                }
+            }
+        }
+    }
+
+    return entities;
 }
 
 Entity EntityDatabaseImpl::init_entity_copy(Entity entity, const EntityArchetype& archetype)
 {
     assert(has_entity(entity));
+    assert(has_components(archetype));
+    auto new_entity{ generate_new_entity() };
+    const auto& src_entity_slot{ m_entity_slots[entity.id] };
+    const auto& src_entity_container{ *m_entity_containers[src_entity_slot.container_id] };
+    auto entity_archetype{ container_archetype(archetype) };
+    auto container_id{ fetch_or_init_entity_container(
+        entity_archetype, shared_value_ids(entity_archetype, &src_entity_container)) };
+    auto entity_location{ m_entity_containers[container_id]->init_copy(
+        new_entity, src_entity_container, src_entity_slot.location) };
+    m_entity_slots[new_entity.id].container_id = container_id;
+    m_entity_slots[new_entity.id].location = entity_location;
+    invalidate_relation_indices(container_id);
+    observe_signature_change(new_entity, ComponentSignature{}, m_entity_containers[container_id]->signature());
+
+    move_sparse_components(new_entity, archetype);
     for (auto component_type : archetype.component_types()) {
-        assert(has_component(component_type));
+        if (m_sparse_components.contains(component_type)
+            && m_sparse_component_sets[component_type]->contains(entity)) {
+            auto& sparse_set{ *m_sparse_component_sets[component_type] };
+            fetch_component_desc(component_type)
+                .copyFunc(sparse_set.fetch_unchecked(entity), sparse_set.fetch_unchecked(new_entity));
+        }
     }
-    auto new_entity{ generate_new_entity() };
-    auto& entity_container{ fetch_or_init_entity_container(archetype) };
-    const auto& src_entity_container{ fetch_entity_container(entity) };
-    auto src_entity_location{ src_entity_container.entity_location(entity) };
-    m_entities.emplace(new_entity, m_archetype_map.at(archetype));
-    entity_container.init_copy(new_entity, src_entity_container, src_entity_location);
     return new_entity;
 }
 
 void EntityDatabaseImpl::erase_entity(Entity entity)
 {
     assert(has_entity(entity));
-    auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
-    entity_container.erase(entity_location);
-
-    m_entities.erase(entity);
-    m_free_entities.push_back(Entity{ entity.id, entity.generation + 1 });
+    move_sparse_components(entity, EntityArchetype{});
+    auto& entity_slot{ m_entity_slots[entity.id] };
+    observe_signature_change(entity, m_entity_containers[entity_slot.container_id]->signature(), ComponentSignature{});
+    erase_from_container(entity_slot.container_id, entity_slot.location);
+
+    // The relating entities of an erased entity are dropped from the index, as its id may be reused.
+    for (const auto& relation_index : m_relation_indices) {
+        if (relation_index == nullptr || relation_index->snapshot == nullptr) {
+            continue;
+        }
 
-    if (entity_container.size() == 0) {
-        auto container_id{ m_entities.at(entity) };
-        auto container_archetype{ entity_container.archetype() };
-        m_entity_containers.erase(container_id);
-        m_archetype_map.erase(container_archetype);
-        for (auto component_type : container_archetype.component_types()) {
-            m_type_associations.at(component_type).erase(container_id);
+        const auto& offsets{ relation_index->snapshot->offsets };
+        if (entity.id + 1 < offsets.size() && offsets[entity.id] != offsets[entity.id + 1]) {
+            relation_index->dirty = true;
         }
-        m_free_container_ids.push_back(container_id);
     }
+
+    entity_slot.generation++;
+    entity_slot.container_id = INVALID_CONTAINER_ID;
+    entity_slot.location = INVALID_ENTITY_LOCATION;
+    m_free_entity_ids.push_back(entity.id);
 }
 
-void EntityDatabaseImpl::move_entity(Entity entity, const EntityArchetype& archetype)
+void EntityDatabaseImpl::erase_entity_recursive(Entity entity, ComponentType component_type)
 {
     assert(has_entity(entity));
-    for (auto component_type : archetype.component_types()) {
-        assert(has_component(component_type));
-    }
-    auto& dst_entity_container{ fetch_or_init_entity_container(archetype) };
-    auto& src_entity_container{ fetch_entity_container(entity) };
-    if (&dst_entity_container != &src_entity_container) {
-        auto src_entity_location{ src_entity_container.entity_location(entity) };
-        dst_entity_container.init_move(entity, src_entity_container, src_entity_location);
-
-        if (src_entity_container.size() == 0) {
-            auto src_entity_container_id{ m_entities.at(entity) };
-            auto container_archetype{ src_entity_container.archetype() };
-            m_entity_containers.erase(src_entity_container_id);
-            m_archetype_map.erase(container_archetype);
-            for (auto component_type : container_archetype.component_types()) {
-                m_type_associations.at(component_type).erase(src_entity_container_id);
-            }
-            m_free_container_ids.push_back(src_entity_container_id);
-        }
 
-        m_entities.at(entity) = m_archetype_map.at(archetype);
+    // The entities are collected before erasing them, which invalidates the index.
+    std::vector<Entity> entities{ entity };
+    for (std::size_t i{ 0 }; i < entities.size(); ++i) {
+        auto related_entities{ fetch_related_entities(entities[i], component_type) };
+        entities.insert(entities.end(), related_entities.begin(), related_entities.end());
+    }
+    for (auto related_entity : entities) {
+        erase_entity(related_entity);
     }
 }
 
+void EntityDatabaseImpl::move_entity(Entity entity, const EntityArchetype& archetype)
+{
+    assert(has_entity(entity));
+    assert(has_components(archetype));
+    const auto& entity_container{ *m_entity_containers[m_entity_slots[entity.id].container_id] };
+    auto entity_archetype{ container_archetype(archetype) };
+    move_to_container(entity,
+        fetch_or_init_entity_container(entity_archetype, shared_value_ids(entity_archetype, &entity_container)));
+    move_sparse_components(entity, archetype);
+}
+
 void EntityDatabaseImpl::add_component(Entity entity, ComponentType component_type)
 {
     assert(has_entity(entity));
     assert(has_component(component_type));
-    auto src_archetype{ fetch_entity_archetype(entity) };
-    auto dst_archetype{ src_archetype.with(component_type) };
-    move_entity(entity, dst_archetype);
+    if (m_sparse_components.contains(component_type)) {
+        if (!m_sparse_component_sets[component_type]->contains(entity)) {
+            m_sparse_component_sets[component_type]->init(entity);
+            observe_add(entity, component_type);
+        }
+        return;
+    }
+
+    auto container_id{ m_entity_slots[entity.id].container_id };
+    move_to_container(entity, fetch_or_init_add_edge(container_id, component_type));
 }
 
 void EntityDatabaseImpl::add_component_move(Entity entity, ComponentType component_type, void* src)
@@ -160,10 +435,16 @@ void EntityDatabaseImpl::remove_component(Entity entity, ComponentType component
 {
     assert(has_entity(entity));
     assert(has_component(component_type));
-    auto& src_entity_container{ fetch_entity_container(entity) };
-    auto src_archetype{ src_entity_container.archetype() };
-    auto dst_archetype{ src_archetype.without(component_type) };
-    move_entity(entity, dst_archetype);
+    if (m_sparse_components.contains(component_type)) {
+        if (m_sparse_component_sets[component_type]->contains(entity)) {
+            m_sparse_component_sets[component_type]->erase(entity);
+            observe_remove(entity, component_type);
+        }
+        return;
+    }
+
+    auto container_id{ m_entity_slots[entity.id].container_id };
+    move_to_container(entity, fetch_or_init_remove_edge(container_id, component_type));
 }
 
 void EntityDatabaseImpl::read_component(Entity entity, ComponentType component_type, void* dst) const
@@ -171,10 +452,22 @@ void EntityDatabaseImpl::read_component(Entity entity, ComponentType component_t
     assert(has_entity(entity));
     assert(has_component(component_type));
     assert(entity_has_component(entity, component_type));
-    const auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    const auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    if (m_shared_components.contains(component_type)) {
+        fetch_component_desc(component_type).copyFunc(entity_container.fetch_shared_unchecked(component_type), dst);
+        return;
+    } else if (m_tag_components.contains(component_type)) {
+        // Tags have no state, there is nothing to read or write.
+        return;
+    } else if (m_sparse_components.contains(component_type)) {
+        const auto& sparse_set{ *m_sparse_component_sets[component_type] };
+        fetch_component_desc(component_type).copyFunc(sparse_set.fetch_unchecked(entity), dst);
+        return;
+    }
+
     auto component_idx{ entity_container.component_idx(component_type) };
-    entity_container.read(entity_location, component_idx, dst);
+    entity_container.read(entity_slot.location, component_idx, dst);
 }
 
 void EntityDatabaseImpl::write_component_move(Entity entity, ComponentType component_type, void* src)
@@ -182,10 +475,23 @@ void EntityDatabaseImpl::write_component_move(Entity entity, ComponentType compo
     assert(has_entity(entity));
     assert(has_component(component_type));
     assert(entity_has_component(entity, component_type));
-    auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
+    observe_write(entity, component_type);
+    if (m_shared_components.contains(component_type)) {
+        write_shared_component(entity, component_type, fetch_or_init_shared_value_move(component_type, src));
+        return;
+    } else if (m_tag_components.contains(component_type)) {
+        return;
+    } else if (m_sparse_components.contains(component_type)) {
+        auto& sparse_set{ *m_sparse_component_sets[component_type] };
+        fetch_component_desc(component_type).moveFunc(src, sparse_set.fetch_unchecked(entity));
+        return;
+    }
+
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
     auto component_idx{ entity_container.component_idx(component_type) };
-    entity_container.write_move(entity_location, component_idx, src);
+    entity_container.write_move(entity_slot.location, component_idx, src);
+    invalidate_relation_index(component_type);
 }
 
 void EntityDatabaseImpl::write_component_copy(Entity entity, ComponentType component_type, const void* src)
@@ -193,10 +499,23 @@ void EntityDatabaseImpl::write_component_copy(Entity entity, ComponentType compo
     assert(has_entity(entity));
     assert(has_component(component_type));
     assert(entity_has_component(entity, component_type));
-    auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
+    observe_write(entity, component_type);
+    if (m_shared_components.contains(component_type)) {
+        write_shared_component(entity, component_type, fetch_or_init_shared_value_copy(component_type, src));
+        return;
+    } else if (m_tag_components.contains(component_type)) {
+        return;
+    } else if (m_sparse_components.contains(component_type)) {
+        auto& sparse_set{ *m_sparse_component_sets[component_type] };
+        fetch_component_desc(component_type).copyFunc(src, sparse_set.fetch_unchecked(entity));
+        return;
+    }
+
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
     auto component_idx{ entity_container.component_idx(component_type) };
-    entity_container.write_copy(entity_location, component_idx, src);
+    entity_container.write_copy(entity_slot.location, component_idx, src);
+    invalidate_relation_index(component_type);
 }
 
 void* EntityDatabaseImpl::fetch_component_unchecked(Entity entity, ComponentType component_type)
@@ -204,10 +523,19 @@ void* EntityDatabaseImpl::fetch_component_unchecked(Entity entity, ComponentType
     assert(has_entity(entity));
     assert(has_component(component_type));
     assert(entity_has_component(entity, component_type));
-    auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
+    assert(!m_shared_components.contains(component_type));
+    observe_write(entity, component_type);
+    if (m_tag_components.contains(component_type)) {
+        return fetch_tag_value(component_type);
+    } else if (m_sparse_components.contains(component_type)) {
+        return m_sparse_component_sets[component_type]->fetch_unchecked(entity);
+    }
+
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
     auto component_idx{ entity_container.component_idx(component_type) };
-    return entity_container.fetch_unchecked(entity_location, component_idx);
+    invalidate_relation_index(component_type);
+    return entity_container.fetch_unchecked(entity_slot.location, component_idx);
 }
 
 const void* EntityDatabaseImpl::fetch_component_unchecked(Entity entity, ComponentType component_type) const
@@ -215,245 +543,1005 @@ const void* EntityDatabaseImpl::fetch_component_unchecked(Entity entity, Compone
     assert(has_entity(entity));
     assert(has_component(component_type));
     assert(entity_has_component(entity, component_type));
-    auto& entity_container{ fetch_entity_container(entity) };
-    auto entity_location{ entity_container.entity_location(entity) };
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    const auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    if (m_shared_components.contains(component_type)) {
+        return entity_container.fetch_shared_unchecked(component_type);
+    } else if (m_tag_components.contains(component_type)) {
+        return fetch_tag_value(component_type);
+    } else if (m_sparse_components.contains(component_type)) {
+        return std::as_const(*m_sparse_component_sets[component_type]).fetch_unchecked(entity);
+    }
+
     auto component_idx{ entity_container.component_idx(component_type) };
-    return entity_container.fetch_unchecked(entity_location, component_idx);
+    return entity_container.fetch_unchecked(entity_slot.location, component_idx);
 }
 
 EntityContainer& EntityDatabaseImpl::fetch_entity_container(Entity entity)
 {
     assert(has_entity(entity));
-    auto container_id{ m_entities.at(entity) };
-    return m_entity_containers.at(container_id);
+    return *m_entity_containers[m_entity_slots[entity.id].container_id];
 }
 
 const EntityContainer& EntityDatabaseImpl::fetch_entity_container(Entity entity) const
 {
     assert(has_entity(entity));
-    auto container_id{ m_entities.at(entity) };
-    return m_entity_containers.at(container_id);
+    return *m_entity_containers[m_entity_slots[entity.id].container_id];
+}
+
+SparseComponentSet* EntityDatabaseImpl::fetch_sparse_component_set(ComponentType component_type) const
+{
+    if (!m_sparse_components.contains(component_type)) {
+        return nullptr;
+    }
+    return m_sparse_component_sets[component_type].get();
+}
+
+EntityLocation EntityDatabaseImpl::fetch_entity_location(Entity entity) const
+{
+    assert(has_entity(entity));
+    return m_entity_slots[entity.id].location;
 }
 
 EntityArchetype EntityDatabaseImpl::fetch_entity_archetype(Entity entity) const
 {
     assert(has_entity(entity));
-    return fetch_entity_container(entity).archetype();
+    auto archetype{ fetch_entity_container(entity).archetype() };
+    for (ComponentType component_type{ 0 }; component_type < m_sparse_component_sets.size(); ++component_type) {
+        const auto& sparse_set{ m_sparse_component_sets[component_type] };
+        if (sparse_set != nullptr && sparse_set->contains(entity)) {
+            archetype = archetype.with(component_type);
+        }
+    }
+    return archetype;
 }
 
-template <typename T, typename It> void set_intersection_in_place(T& cont, It first2, It last2)
+std::size_t EntityDatabaseImpl::fetch_component_version(Entity entity, ComponentType component_type) const
 {
-    auto it1{ std::begin(cont) };
-    auto it2{ first2 };
+    assert(has_entity(entity));
+    assert(entity_has_component(entity, component_type));
+    assert(has_column(component_type));
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    const auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    const auto& entity_chunk{ entity_container.entity_chunk(entity_slot.location.chunk_idx) };
+    return entity_chunk.component_chunk(entity_container.component_idx(component_type)).version();
+}
 
-    while (it1 != std::end(cont) && it2 != last2) {
-        if (*it1 < *it2) {
-            it1 = cont.erase(it1);
-        } else if (*it2 < *it1) {
-            ++it2;
-        } else {
-            ++it1;
-            ++it2;
-        }
+bool EntityDatabaseImpl::is_component_enabled(Entity entity, ComponentType component_type) const
+{
+    assert(has_entity(entity));
+    assert(entity_has_component(entity, component_type));
+    assert(fetch_component_desc(component_type).enableable);
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    const auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    const auto& entity_chunk{ entity_container.entity_chunk(entity_slot.location.chunk_idx) };
+    return entity_chunk.component_chunk(entity_container.component_idx(component_type))
+        .is_enabled(entity_slot.location.entity_idx);
+}
+
+void EntityDatabaseImpl::set_component_enabled(Entity entity, ComponentType component_type, bool enabled)
+{
+    assert(has_entity(entity));
+    assert(entity_has_component(entity, component_type));
+    assert(fetch_component_desc(component_type).enableable);
+    const auto& entity_slot{ m_entity_slots[entity.id] };
+    auto& entity_container{ *m_entity_containers[entity_slot.container_id] };
+    auto& entity_chunk{ entity_container.entity_chunk(entity_slot.location.chunk_idx) };
+    entity_chunk.component_chunk(entity_container.component_idx(component_type))
+        .set_enabled(entity_slot.location.entity_idx, enabled);
+}
+
+RelatedEntities EntityDatabaseImpl::fetch_related_entities(Entity entity, ComponentType component_type) const
+{
+    assert(has_entity(entity));
+    auto snapshot{ fetch_relation_snapshot(component_type) };
+    const auto& offsets{ snapshot->offsets };
+
+    // Entities created after the index was built can not be related to, otherwise the index would be dirty.
+    if (entity.id + 1 >= offsets.size()) {
+        return {};
     }
+    std::span entities{ snapshot->sources };
+    entities = entities.subspan(offsets[entity.id], offsets[entity.id + 1] - offsets[entity.id]);
+    return RelatedEntities{ std::move(snapshot), entities };
+}
+
+std::size_t EntityDatabaseImpl::global_version() const { return m_global_version.load(std::memory_order_relaxed); }
 
-    cont.erase(it1, std::end(cont));
+std::size_t EntityDatabaseImpl::increment_global_version()
+{
+    return m_global_version.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
-template <typename T, typename It> void set_union_in_place(T& cont, It first2, It last2)
+std::size_t EntityDatabaseImpl::archetype_count() const { return m_entity_containers.size(); }
+
+bool EntityDatabaseImpl::queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const
 {
-    auto it1{ std::begin(cont) };
-    auto it2{ first2 };
+    // Ignoring the sparse components overestimates the intersection, which is safe for scheduling.
+    auto lhs_query{ container_query(lhs) };
+    auto rhs_query{ container_query(rhs) };
+    return std::any_of(m_container_signatures.begin(), m_container_signatures.end(),
+        [&](const ComponentSignature& signature) {
+            return lhs_query.matches(signature) && rhs_query.matches(signature);
+        });
+}
 
-    while (it1 != std::end(cont) && it2 != last2) {
-        if (*it1 < *it2) {
-            ++it1;
-        } else if (*it2 < *it1) {
-            it1 = cont.insert(it1, *it2);
-            ++it2;
-        } else {
-            ++it1;
-            ++it2;
+EntityCompactionStatistics EntityDatabaseImpl::compact()
+{
+    EntityCompactionStatistics statistics{};
+    for (auto& entity_container : m_entity_containers) {
+        auto released_chunks{ entity_container->shrink_to_fit() };
+
+        // Pooled blocks are freed by trimming the pool, the others were freed together with their chunks.
+        const auto& layout{ entity_container->layout() };
+        if (!m_chunk_pool.is_pooled(layout.block_size(), layout.block_alignment())) {
+            statistics.reclaimed_bytes += released_chunks * layout.block_size();
         }
+        statistics.entity_count += entity_container->size();
+        statistics.entity_capacity += entity_container->capacity();
     }
+    statistics.reclaimed_bytes += m_chunk_pool.trim();
+    return statistics;
+}
 
-    cont.insert(it1, it2, last2);
+EntityObserverId EntityDatabaseImpl::register_observer(ComponentType component_type)
+{
+    assert(has_component(component_type));
+    std::scoped_lock lock{ m_observer_mutex };
+    if (component_type >= m_recorded_observations.size()) {
+        m_recorded_observations.resize(component_type + 1);
+    }
+    m_observed_components.insert(component_type);
+    m_observers.push_back(ComponentObserver{ component_type, EntityObservation{} });
+    return m_observers.size() - 1;
 }
 
-template <typename T, typename It> void set_difference_in_place(T& cont, It first2, It last2)
+EntityObservation EntityDatabaseImpl::take_observation(EntityObserverId observer_id)
 {
-    auto it1{ std::begin(cont) };
-    auto it2{ first2 };
+    std::scoped_lock lock{ m_observer_mutex };
+    assert(observer_id < m_observers.size());
+    return std::exchange(m_observers[observer_id].observation, EntityObservation{});
+}
 
-    while (it1 != std::end(cont) && it2 != last2) {
-        if (*it1 < *it2) {
-            ++it1;
-        } else if (*it2 < *it1) {
-            ++it2;
-        } else {
-            it1 = cont.erase(it1);
-            ++it2;
+void EntityDatabaseImpl::publish_observations()
+{
+    std::scoped_lock lock{ m_observer_mutex };
+    // The sync point excludes the contexts, so the write logs are not written concurrently.
+    for (auto& write_log : m_write_logs) {
+        for (auto [component_type, entity] : *write_log) {
+            m_recorded_observations[component_type].written.push_back(entity);
         }
+        write_log->clear();
+    }
+
+    // Observations which were not taken since the last sync point accumulate the changes.
+    for (auto& observer : m_observers) {
+        const auto& recorded_observation{ m_recorded_observations[observer.component_type] };
+        auto& observation{ observer.observation };
+        observation.added.insert(
+            observation.added.end(), recorded_observation.added.begin(), recorded_observation.added.end());
+        observation.removed.insert(
+            observation.removed.end(), recorded_observation.removed.begin(), recorded_observation.removed.end());
+        observation.written.insert(
+            observation.written.end(), recorded_observation.written.begin(), recorded_observation.written.end());
+        reconcile_observation(observation, observer.component_type);
+    }
+
+    for (auto& recorded_observation : m_recorded_observations) {
+        recorded_observation.added.clear();
+        recorded_observation.removed.clear();
+        recorded_observation.written.clear();
     }
 }
 
-EntityDBWindow EntityDatabaseImpl::query_db_window(const EntityDBQuery& query)
+void EntityDatabaseImpl::reconcile_observation(EntityObservation& observation, ComponentType component_type) const
 {
-    auto required_components{ query.required_components() };
-    auto prohibited_components{ query.prohibited_components() };
-    auto optional_components{ query.optional_components() };
+    auto& added{ observation.added };
+    auto& removed{ observation.removed };
+    auto& written{ observation.written };
+    std::sort(added.begin(), added.end(), entity_less);
+    std::sort(removed.begin(), removed.end(), entity_less);
+
+    // The additions and removals of an entity alternate, so only the net change is reported. An entity which lost
+    // and regained the component holds a new value, which is reported as a write.
+    std::vector<Entity> net_added{};
+    std::vector<Entity> net_removed{};
+    auto added_it{ added.begin() };
+    auto removed_it{ removed.begin() };
+    while (added_it != added.end() || removed_it != removed.end()) {
+        auto entity{ removed_it == removed.end() || (added_it != added.end() && entity_less(*added_it, *removed_it))
+                ? *added_it
+                : *removed_it };
+        auto added_end{ std::find_if(added_it, added.end(), [&](Entity other) { return other != entity; }) };
+        auto removed_end{ std::find_if(removed_it, removed.end(), [&](Entity other) { return other != entity; }) };
+        auto added_count{ added_end - added_it };
+        auto removed_count{ removed_end - removed_it };
+        if (added_count > removed_count) {
+            net_added.push_back(entity);
+        } else if (removed_count > added_count) {
+            net_removed.push_back(entity);
+        } else if (has_entity(entity) && entity_has_component(entity, component_type)) {
+            written.push_back(entity);
+        }
+        added_it = added_end;
+        removed_it = removed_end;
+    }
+    added = std::move(net_added);
+    removed = std::move(net_removed);
 
-    std::vector<Entity> entities{};
-    std::vector<std::vector<void*>> components{};
-    std::unordered_map<ComponentType, std::size_t> component_type_map;
+    std::sort(written.begin(), written.end(), entity_less);
+    written.erase(std::unique(written.begin(), written.end()), written.end());
+}
 
-    components.reserve(required_components.size() + optional_components.size());
-    component_type_map.reserve(required_components.size() + optional_components.size());
-    for (std::size_t i{ 0 }; i < required_components.size(); ++i) {
-        components.emplace_back();
-        component_type_map.insert({ required_components[i], i });
-    }
-    for (std::size_t i{ 0 }; i < optional_components.size(); ++i) {
-        components.emplace_back();
-        component_type_map.insert({ optional_components[i], i + required_components.size() });
+EntityDBQueryId EntityDatabaseImpl::register_query(const EntityDBQuery& query)
+{
+    std::scoped_lock lock{ m_query_mutex };
+    for (EntityDBQueryId query_id{ 0 }; query_id < m_query_caches.size(); ++query_id) {
+        if (m_query_caches[query_id].query.matches(query)) {
+            return query_id;
+        }
     }
 
-    std::vector<EntityContainerId> required_container_ids{};
-    if (required_components.size() > 0) {
-        if (auto pos{ m_type_associations.find(required_components[0]) }; pos != m_type_associations.end()) {
-            required_container_ids = { pos->second.begin(), pos->second.end() };
+    QueryCache query_cache{ query, container_query(query), {} };
+    query_cache.query.m_registered_database = nullptr;
+    for (EntityContainerId container_id{ 0 }; container_id < m_container_signatures.size(); ++container_id) {
+        if (query_cache.container_query.matches(m_container_signatures[container_id])) {
+            query_cache.container_ids.push_back(container_id);
         }
+    }
 
-        for (std::size_t i{ 1 }; i < required_components.size() && !required_container_ids.empty(); ++i) {
-            if (auto pos{ m_type_associations.find(required_components[i]) }; pos != m_type_associations.end()) {
-                set_intersection_in_place(required_container_ids, pos->second.begin(), pos->second.end());
+    m_query_caches.push_back(std::move(query_cache));
+    return m_query_caches.size() - 1;
+}
+
+EntityDBWindow EntityDatabaseImpl::query_db_window(EntityDBQueryId query_id)
+{
+    std::unique_lock lock{ m_query_mutex };
+    assert(m_query_caches.size() > query_id);
+    const auto& query_cache{ m_query_caches[query_id] };
+    lock.unlock();
+
+    auto required_components{ query_cache.query.required_components() };
+    auto optional_components{ query_cache.query.optional_components() };
+
+    std::vector<EntityDBWindowChunk> chunks{};
+    std::vector<ComponentChunk*> components{};
+    std::vector<ComponentType> component_types{};
+    std::vector<std::size_t> component_sizes{};
+
+    component_types.reserve(required_components.size() + optional_components.size());
+    component_types.insert(component_types.end(), required_components.begin(), required_components.end());
+    component_types.insert(component_types.end(), optional_components.begin(), optional_components.end());
+
+    component_sizes.reserve(component_types.size());
+    for (auto component_type : component_types) {
+        component_sizes.push_back(fetch_component_desc(component_type).size);
+    }
+
+    std::vector<std::optional<std::size_t>> component_indices{};
+    component_indices.reserve(component_types.size());
+
+    // The sparse components of the query are checked per entity, as the containers do not know them.
+    std::vector<const SparseComponentSet*> required_sparse_sets{};
+    std::vector<const SparseComponentSet*> prohibited_sparse_sets{};
+    // Entities whose required enableable components are disabled are skipped as well.
+    std::vector<ComponentType> enableable_components{};
+    for (auto component_type : required_components) {
+        if (m_sparse_components.contains(component_type)) {
+            required_sparse_sets.push_back(m_sparse_component_sets[component_type].get());
+        } else if (fetch_component_desc(component_type).enableable) {
+            enableable_components.push_back(component_type);
+        }
+    }
+    for (auto component_type : query_cache.query.prohibited_components()) {
+        if (m_sparse_components.contains(component_type)) {
+            prohibited_sparse_sets.push_back(m_sparse_component_sets[component_type].get());
+        }
+    }
+    auto sparse_filtered{ !required_sparse_sets.empty() || !prohibited_sparse_sets.empty() };
+    auto sparse_matches{ [&](Entity entity) {
+        return std::all_of(required_sparse_sets.begin(), required_sparse_sets.end(),
+                   [&](const SparseComponentSet* sparse_set) { return sparse_set->contains(entity); })
+            && std::none_of(prohibited_sparse_sets.begin(), prohibited_sparse_sets.end(),
+                [&](const SparseComponentSet* sparse_set) { return sparse_set->contains(entity); });
+    } };
+
+    constexpr auto word_bits{ ComponentChunk::ENABLED_WORD_BITS };
+    std::vector<std::size_t> enableable_indices{};
+    std::vector<std::uint64_t> entity_mask{};
+
+    std::size_t entity_offset{ 0 };
+    for (auto container_id : query_cache.container_ids) {
+        auto& entity_container{ *m_entity_containers[container_id] };
+
+        // Shared components have no column, they are fetched from the container of the chunk. Tags have neither.
+        for (auto component_type : component_types) {
+            if (entity_container.has_component(component_type) && has_column(component_type)) {
+                component_indices.push_back(entity_container.component_idx(component_type));
             } else {
-                required_container_ids.clear();
+                component_indices.push_back(std::nullopt);
+            }
+        }
+        for (auto component_type : enableable_components) {
+            enableable_indices.push_back(entity_container.component_idx(component_type));
+        }
+
+        auto entity_chunks{ entity_container.entity_chunks() };
+        for (std::size_t chunk_idx{ 0 }; chunk_idx < entity_chunks.size(); ++chunk_idx) {
+            auto& entity_chunk{ entity_chunks[chunk_idx] };
+            auto entities{ entity_chunk.entities() };
+            auto push_run{ [&](std::size_t run_start, std::size_t run_end) {
+                chunks.push_back({ entities.subspan(run_start, run_end - run_start), entity_offset, components.size(),
+                    run_start, chunk_idx, &entity_container });
+                for (auto component_idx : component_indices) {
+                    components.push_back(component_idx ? &entity_chunk.component_chunk(*component_idx) : nullptr);
+                }
+                entity_offset += run_end - run_start;
+            } };
+
+            // The counters decide most chunks at once, only partially enabled chunks require their bits.
+            auto filtered{ sparse_filtered };
+            auto disabled{ entities.empty() };
+            for (auto component_idx : enableable_indices) {
+                const auto& component_chunk{ entity_chunk.component_chunk(component_idx) };
+                disabled = disabled || component_chunk.enabled_size() == 0;
+                filtered = filtered || component_chunk.enabled_size() != component_chunk.size();
+            }
+            if (disabled) {
+                continue;
+            } else if (!filtered) {
+                push_run(0, entities.size());
+                continue;
+            }
+
+            // Otherwise every run of consecutive matching entities becomes its own chunk of the window,
+            // like in `EntityDBWindow::filter`.
+            entity_mask.assign((entities.size() + word_bits - 1) / word_bits, ~std::uint64_t{ 0 });
+            if (entities.size() % word_bits != 0) {
+                entity_mask.back() = (std::uint64_t{ 1 } << (entities.size() % word_bits)) - 1;
+            }
+            for (auto component_idx : enableable_indices) {
+                auto enabled_words{ entity_chunk.component_chunk(component_idx).enabled_words() };
+                for (std::size_t word_idx{ 0 }; word_idx < entity_mask.size(); ++word_idx) {
+                    entity_mask[word_idx] &= enabled_words[word_idx];
+                }
+            }
+            if (sparse_filtered) {
+                for (std::size_t i{ 0 }; i < entities.size(); ++i) {
+                    if (!sparse_matches(entities[i])) {
+                        entity_mask[i / word_bits] &= ~(std::uint64_t{ 1 } << (i % word_bits));
+                    }
+                }
+            }
+
+            for (auto run_start{ find_mask_bit(entity_mask, 0, true) }; run_start < entities.size();) {
+                auto run_end{ find_mask_bit(entity_mask, run_start, false) };
+                push_run(run_start, run_end);
+                run_start = find_mask_bit(entity_mask, run_end, true);
             }
         }
+
+        component_indices.clear();
+        enableable_indices.clear();
     }
 
-    if (required_container_ids.empty()) {
-        return EntityDBWindow{ std::move(entities), std::move(components), std::move(component_type_map) };
+    return EntityDBWindow{ this, std::move(chunks), std::move(components), std::move(component_types),
+        std::move(component_sizes) };
+}
+
+EntityDBWindow EntityDatabaseImpl::query_db_window(EntityDBQuery& query)
+{
+    if (query.m_registered_database != this) {
+        query.m_registered_id = register_query(query);
+        query.m_registered_database = this;
     }
+    return query_db_window(query.m_registered_id);
+}
+
+EntityDBWindow EntityDatabaseImpl::query_db_window(const EntityDBQuery& query)
+{
+    return query_db_window(register_query(query));
+}
 
-    std::vector<EntityContainerId> prohibited_container_ids{};
-    for (auto prohibited_component : prohibited_components) {
-        if (auto pos{ m_type_associations.find(prohibited_component) }; pos != m_type_associations.end()) {
-            set_union_in_place(prohibited_container_ids, pos->second.begin(), pos->second.end());
+EntityDBWindow EntityDatabaseImpl::query_db_window(const EntityRange& entities)
+{
+    if (entities.empty()) {
+        return EntityDBWindow{ this, {}, {}, {}, {} };
+    }
+
+    assert(has_entity(entities.front()));
+    assert(has_entity(entities.back()));
+    const auto& first_slot{ m_entity_slots[entities.front().id] };
+    auto& entity_container{ *m_entity_containers[first_slot.container_id] };
+    auto archetype{ entity_container.archetype() };
+    auto archetype_components{ archetype.component_types() };
+
+    std::vector<EntityDBWindowChunk> chunks{};
+    std::vector<ComponentChunk*> components{};
+    std::vector<ComponentType> component_types{ archetype_components.begin(), archetype_components.end() };
+    std::vector<std::size_t> component_sizes{};
+
+    component_sizes.reserve(component_types.size());
+    for (auto component_type : component_types) {
+        component_sizes.push_back(fetch_component_desc(component_type).size);
+    }
+
+    // The entities of a range are stored consecutively, starting at the location of the first entity.
+    auto entity_location{ first_slot.location };
+    for (std::size_t entity_offset{ 0 }; entity_offset < entities.size(); entity_location.chunk_idx++) {
+        auto& entity_chunk{ entity_container.entity_chunk(entity_location.chunk_idx) };
+        auto count{ std::min(entity_chunk.size() - entity_location.entity_idx, entities.size() - entity_offset) };
+        auto chunk_entities{ entity_chunk.entities().subspan(entity_location.entity_idx, count) };
+        assert(chunk_entities.front() == entities[entity_offset]);
+        assert(chunk_entities.back() == entities[entity_offset + count - 1]);
+
+        chunks.push_back({ chunk_entities, entity_offset, components.size(), entity_location.entity_idx,
+            entity_location.chunk_idx, &entity_container });
+        for (auto component_type : component_types) {
+            components.push_back(has_column(component_type)
+                    ? &entity_chunk.component_chunk(entity_chunk.component_idx(component_type))
+                    : nullptr);
         }
+
+        entity_offset += count;
+        entity_location.entity_idx = 0;
     }
 
-    if (!prohibited_container_ids.empty()) {
-        set_difference_in_place(
-            required_container_ids, prohibited_container_ids.begin(), prohibited_container_ids.end());
+    return EntityDBWindow{ this, std::move(chunks), std::move(components), std::move(component_types),
+        std::move(component_sizes) };
+}
+
+bool EntityDatabaseImpl::has_components(const EntityArchetype& archetype) const
+{
+    auto component_types{ archetype.component_types() };
+    return std::all_of(component_types.begin(), component_types.end(),
+        [this](ComponentType component_type) { return has_component(component_type); });
+}
+
+Entity EntityDatabaseImpl::generate_new_entity()
+{
+    if (m_free_entity_ids.empty()) {
+        auto entity{ Entity{ m_entity_slots.size(), 0 } };
+        m_entity_slots.push_back(EntitySlot{ entity.generation, INVALID_CONTAINER_ID, INVALID_ENTITY_LOCATION });
+        return entity;
+    } else {
+        auto entity_id{ m_free_entity_ids.back() };
+        m_free_entity_ids.pop_back();
+        return Entity{ entity_id, m_entity_slots[entity_id].generation };
     }
+}
 
-    if (required_container_ids.empty()) {
-        return EntityDBWindow{ std::move(entities), std::move(components), std::move(component_type_map) };
+Entity EntityDatabaseImpl::init_entity(EntityContainerId container_id)
+{
+    auto entity{ generate_new_entity() };
+    auto entity_location{ m_entity_containers[container_id]->init(entity) };
+    m_entity_slots[entity.id].container_id = container_id;
+    m_entity_slots[entity.id].location = entity_location;
+    invalidate_relation_indices(container_id);
+    observe_signature_change(entity, ComponentSignature{}, m_entity_containers[container_id]->signature());
+    return entity;
+}
+
+void EntityDatabaseImpl::move_to_container(Entity entity, EntityContainerId container_id)
+{
+    auto& entity_slot{ m_entity_slots[entity.id] };
+    if (container_id != entity_slot.container_id) {
+        auto& dst_entity_container{ *m_entity_containers[container_id] };
+        auto& src_entity_container{ *m_entity_containers[entity_slot.container_id] };
+        auto entity_location{ dst_entity_container.init_move(entity, src_entity_container, entity_slot.location) };
+        observe_signature_change(entity, src_entity_container.signature(), dst_entity_container.signature());
+        erase_from_container(entity_slot.container_id, entity_slot.location);
+        entity_slot.container_id = container_id;
+        entity_slot.location = entity_location;
+        invalidate_relation_indices(container_id);
+    }
+}
+
+void EntityDatabaseImpl::erase_from_container(EntityContainerId container_id, EntityLocation entity_location)
+{
+    // The container fills the hole with its last entity, whose location must be updated.
+    if (auto moved_entity{ m_entity_containers[container_id]->erase(entity_location) }) {
+        m_entity_slots[moved_entity->id].location = entity_location;
+    }
+    invalidate_relation_indices(container_id);
+}
+
+void EntityDatabaseImpl::write_shared_component(Entity entity, ComponentType component_type, SharedValueId value_id)
+{
+    const auto& entity_container{ *m_entity_containers[m_entity_slots[entity.id].container_id] };
+    if (entity_container.shared_value_id(component_type) == value_id) {
+        return;
     }
 
-    std::vector<std::size_t> component_indices{};
-    std::vector<bool> optional_component_presence{};
+    // The entity joins the container which stores the new value, its archetype stays the same.
+    auto shared_component_types{ entity_container.shared_component_types() };
+    auto component_pos{ std::lower_bound(
+        shared_component_types.begin(), shared_component_types.end(), component_type) };
+    std::vector<SharedValueId> shared_value_ids{ entity_container.shared_value_ids().begin(),
+        entity_container.shared_value_ids().end() };
+    shared_value_ids[std::distance(shared_component_types.begin(), component_pos)] = value_id;
+    move_to_container(entity, fetch_or_init_entity_container(entity_container.archetype(), shared_value_ids));
+}
+
+SharedValueId EntityDatabaseImpl::fetch_or_init_shared_value_move(ComponentType component_type, void* src)
+{
+    if (auto value_id{ find_shared_value(component_type, src) }) {
+        return *value_id;
+    }
+    fetch_component_desc(component_type).moveUninitializedFunc(src, allocate_shared_value(component_type));
+    return m_shared_component_values[component_type].size() - 1;
+}
 
-    for (auto container_id : required_container_ids) {
-        auto& entity_container{ m_entity_containers.at(container_id) };
+SharedValueId EntityDatabaseImpl::fetch_or_init_shared_value_copy(ComponentType component_type, const void* src)
+{
+    if (auto value_id{ find_shared_value(component_type, src) }) {
+        return *value_id;
+    }
+    fetch_component_desc(component_type).copyUninitializedFunc(src, allocate_shared_value(component_type));
+    return m_shared_component_values[component_type].size() - 1;
+}
 
-        component_indices.reserve(required_components.size() + optional_components.size());
-        optional_component_presence.reserve(optional_components.size());
-        for (auto component_type : required_components) {
-            auto component_idx{ entity_container.component_idx(component_type) };
-            component_indices.push_back(component_idx);
+std::optional<SharedValueId> EntityDatabaseImpl::find_shared_value(
+    ComponentType component_type, const void* value) const
+{
+    const auto& component_desc{ fetch_component_desc(component_type) };
+    const auto& values{ m_shared_component_values[component_type] };
+    for (SharedValueId value_id{ 0 }; value_id < values.size(); ++value_id) {
+        if (component_desc.equalFunc(values[value_id].get(), value)) {
+            return value_id;
         }
-        for (auto component_type : optional_components) {
-            if (entity_container.has_component(component_type)) {
-                auto component_idx{ entity_container.component_idx(component_type) };
-                component_indices.push_back(component_idx);
-                optional_component_presence.push_back(true);
-            } else {
-                component_indices.push_back(0);
-                optional_component_presence.push_back(false);
+    }
+    return std::nullopt;
+}
+
+void* EntityDatabaseImpl::allocate_shared_value(ComponentType component_type)
+{
+    const auto& component_desc{ fetch_component_desc(component_type) };
+    if (component_type >= m_shared_component_values.size()) {
+        m_shared_component_values.resize(component_type + 1);
+    }
+
+    auto& values{ m_shared_component_values[component_type] };
+    values.emplace_back(AlignedDeleter<std::byte>::allocate(component_desc.alignment, component_desc.size));
+    return values.back().get();
+}
+
+void* EntityDatabaseImpl::fetch_tag_value(ComponentType component_type) const
+{
+    if (!m_tag_components.contains(component_type)) {
+        return nullptr;
+    }
+    return m_shared_component_values[component_type].front().get();
+}
+
+bool EntityDatabaseImpl::has_column(ComponentType component_type) const
+{
+    return !m_shared_components.contains(component_type) && !m_tag_components.contains(component_type)
+        && !m_sparse_components.contains(component_type);
+}
+
+EntityArchetype EntityDatabaseImpl::container_archetype(const EntityArchetype& archetype) const
+{
+    if (!archetype.signature().contains_any(m_sparse_components)) {
+        return archetype;
+    }
+    return archetype.without(m_sparse_components.component_types());
+}
+
+EntityDBQuery EntityDatabaseImpl::container_query(const EntityDBQuery& query) const
+{
+    // Optional components do not take part in matching the containers.
+    EntityDBQuery container_query{ query };
+    for (auto component_types : { query.required_components(), query.prohibited_components() }) {
+        for (auto component_type : component_types) {
+            if (m_sparse_components.contains(component_type)) {
+                container_query.with_optional_component(component_type);
             }
         }
+    }
+    return container_query;
+}
 
-        for (auto& component_vec : components) {
-            component_vec.reserve(component_vec.size() + entity_container.size());
+void EntityDatabaseImpl::move_sparse_components(Entity entity, const EntityArchetype& archetype)
+{
+    for (ComponentType component_type{ 0 }; component_type < m_sparse_component_sets.size(); ++component_type) {
+        auto& sparse_set{ m_sparse_component_sets[component_type] };
+        if (sparse_set == nullptr) {
+            continue;
         }
 
-        for (auto& entity_chunk : entity_container.entity_chunks()) {
-            for (auto& entity : entity_chunk.entities()) {
-                entities.push_back(entity);
-                auto entity_idx{ entity_chunk.entity_idx(entity) };
+        auto has_component{ sparse_set->contains(entity) };
+        if (archetype.has_component(component_type) && !has_component) {
+            sparse_set->init(entity);
+            observe_add(entity, component_type);
+        } else if (!archetype.has_component(component_type) && has_component) {
+            sparse_set->erase(entity);
+            observe_remove(entity, component_type);
+        }
+    }
+}
 
-                for (std::size_t i{ 0 }; i < required_components.size(); ++i) {
-                    auto component_ptr{ const_cast<void*>(
-                        entity_chunk.fetch_unchecked(entity_idx, component_indices[i])) };
-                    components[i].push_back(component_ptr);
-                }
-                for (std::size_t i{ 0 }; i < optional_components.size(); ++i) {
-                    if (optional_component_presence[i]) {
-                        auto component_ptr{ const_cast<void*>(entity_chunk.fetch_unchecked(
-                            entity_idx, component_indices[i + required_components.size()])) };
-                        components[i].push_back(component_ptr);
-                    } else {
-                        components[i + required_components.size()].push_back(nullptr);
+void EntityDatabaseImpl::invalidate_relation_indices(EntityContainerId container_id)
+{
+    const auto& signature{ m_entity_containers[container_id]->signature() };
+    if (!signature.contains_any(m_relation_components)) {
+        return;
+    }
+
+    for (ComponentType component_type{ 0 }; component_type < m_relation_indices.size(); ++component_type) {
+        if (signature.contains(component_type) && m_relation_indices[component_type] != nullptr) {
+            m_relation_indices[component_type]->dirty = true;
+        }
+    }
+}
+
+void EntityDatabaseImpl::invalidate_relation_index(ComponentType component_type)
+{
+    if (m_relation_components.contains(component_type)) {
+        m_relation_indices[component_type]->dirty = true;
+    }
+}
+
+std::shared_ptr<const RelationSnapshot> EntityDatabaseImpl::fetch_relation_snapshot(ComponentType component_type) const
+{
+    assert(m_relation_components.contains(component_type));
+    auto& relation_index{ *m_relation_indices[component_type] };
+
+    // Lookups of lazy contexts may race, but the index only changes if the relationship was written before.
+    std::scoped_lock lock{ relation_index.mutex };
+    auto version{ global_version() };
+    auto changed{ relation_index.dirty.exchange(false) };
+    if (!changed && relation_index.validated_version != version) {
+        // A column written in the version of the build may have been written after it, which is detected by the
+        // comparison including the build version.
+        for (const auto& entity_container : m_entity_containers) {
+            if (!entity_container->has_component(component_type)) {
+                continue;
+            }
+
+            auto component_idx{ entity_container->component_idx(component_type) };
+            auto entity_chunks{ std::as_const(*entity_container).entity_chunks() };
+            changed = std::any_of(entity_chunks.begin(), entity_chunks.end(), [&](const EntityChunk& entity_chunk) {
+                return entity_chunk.component_chunk(component_idx).version() >= relation_index.build_version;
+            });
+            if (changed) {
+                break;
+            }
+        }
+    }
+
+    if (changed || relation_index.snapshot == nullptr) {
+        rebuild_relation_index(component_type, relation_index);
+        relation_index.build_version = version;
+    }
+    relation_index.validated_version = version;
+    return relation_index.snapshot;
+}
+
+void EntityDatabaseImpl::rebuild_relation_index(ComponentType component_type, RelationIndex& relation_index) const
+{
+    auto target_func{ fetch_component_desc(component_type).targetFunc };
+    auto for_each_relation{ [&](auto&& f) {
+        for (const auto& entity_container : m_entity_containers) {
+            if (!entity_container->has_component(component_type)) {
+                continue;
+            }
+
+            auto component_idx{ entity_container->component_idx(component_type) };
+            for (const auto& entity_chunk : std::as_const(*entity_container).entity_chunks()) {
+                const auto& component_chunk{ entity_chunk.component_chunk(component_idx) };
+                auto entities{ entity_chunk.entities() };
+                for (std::size_t i{ 0 }; i < entities.size(); ++i) {
+                    // Relationships to erased entities are dropped, their ids may be reused by new entities.
+                    auto target{ target_func(component_chunk.fetch_unchecked(i)) };
+                    if (has_entity(target)) {
+                        f(target, entities[i]);
                     }
                 }
             }
         }
+    } };
 
-        component_indices.clear();
-        optional_component_presence.clear();
+    // The snapshot is reused, unless it is still held by the result of a lookup. Further references can only be
+    // taken under the mutex of the index, which is held by the caller.
+    if (relation_index.snapshot == nullptr || relation_index.snapshot.use_count() != 1) {
+        relation_index.snapshot = std::make_shared<RelationSnapshot>();
     }
 
-    return EntityDBWindow{ std::move(entities), std::move(components), std::move(component_type_map) };
+    // Counting sort by the id of the target: the counts are accumulated into the offsets, which are advanced while
+    // the entities are inserted and shifted back afterwards.
+    auto& offsets{ relation_index.snapshot->offsets };
+    auto& sources{ relation_index.snapshot->sources };
+    offsets.assign(m_entity_slots.size() + 1, 0);
+    for_each_relation([&](Entity target, Entity) { offsets[target.id + 1]++; });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    sources.resize(offsets.back());
+    for_each_relation([&](Entity target, Entity entity) { sources[offsets[target.id]++] = entity; });
+    std::move_backward(offsets.begin(), offsets.end() - 1, offsets.end());
+    offsets.front() = 0;
 }
 
-Entity EntityDatabaseImpl::generate_new_entity()
+void EntityDatabaseImpl::observe_signature_change(
+    Entity entity, const ComponentSignature& src, const ComponentSignature& dst)
 {
-    if (m_free_entities.empty()) {
-        auto entity{ Entity{ m_last_entity.id + 1, m_last_entity.generation } };
-        m_last_entity = entity;
-        return entity;
-    } else {
-        auto entity{ m_free_entities.back() };
-        m_free_entities.pop_back();
-        return entity;
+    if (!src.contains_any(m_observed_components) && !dst.contains_any(m_observed_components)) {
+        return;
+    }
+
+    for (auto component_type : m_observed_components.component_types()) {
+        auto src_contains{ src.contains(component_type) };
+        auto dst_contains{ dst.contains(component_type) };
+        if (!src_contains && dst_contains) {
+            observe_add(entity, component_type);
+        } else if (src_contains && !dst_contains) {
+            observe_remove(entity, component_type);
+        }
     }
 }
 
-EntityContainer& EntityDatabaseImpl::fetch_or_init_entity_container(const EntityArchetype& archetype)
+void EntityDatabaseImpl::observe_add(Entity entity, ComponentType component_type)
 {
-    if (m_archetype_map.contains(archetype)) {
-        return m_entity_containers.at(m_archetype_map.at(archetype));
-    } else {
-        for (auto component_type : archetype.component_types()) {
-            assert(has_component(component_type));
+    if (m_observed_components.contains(component_type)) {
+        std::scoped_lock lock{ m_observer_mutex };
+        m_recorded_observations[component_type].added.push_back(entity);
+    }
+}
+
+void EntityDatabaseImpl::observe_remove(Entity entity, ComponentType component_type)
+{
+    if (m_observed_components.contains(component_type)) {
+        std::scoped_lock lock{ m_observer_mutex };
+        m_recorded_observations[component_type].removed.push_back(entity);
+    }
+}
+
+void EntityDatabaseImpl::observe_write(Entity entity, ComponentType component_type)
+{
+    if (m_observed_components.contains(component_type)) {
+        fetch_write_log().emplace_back(component_type, entity);
+    }
+}
+
+EntityDatabaseImpl::WriteLog& EntityDatabaseImpl::fetch_write_log()
+{
+    struct ThreadWriteLog {
+        std::weak_ptr<WriteLog> owner;
+        WriteLog* write_log;
+    };
+
+    // The logs are owned by the database, so the entries expire with it, even if its address is reused.
+    thread_local std::unordered_map<const EntityDatabaseImpl*, ThreadWriteLog> t_write_logs{};
+    if (auto it{ t_write_logs.find(this) }; it != t_write_logs.end() && !it->second.owner.expired()) {
+        return *it->second.write_log;
+    }
+
+    std::erase_if(t_write_logs, [](const auto& entry) { return entry.second.owner.expired(); });
+    auto write_log{ std::make_shared<WriteLog>() };
+    t_write_logs.insert_or_assign(this, ThreadWriteLog{ write_log, write_log.get() });
+
+    std::scoped_lock lock{ m_observer_mutex };
+    m_write_logs.push_back(std::move(write_log));
+    return *m_write_logs.back();
+}
+
+std::vector<SharedValueId> EntityDatabaseImpl::shared_value_ids(
+    const EntityArchetype& archetype, const EntityContainer* src_container) const
+{
+    std::vector<SharedValueId> shared_value_ids{};
+    if (!archetype.signature().contains_any(m_shared_components)) {
+        return shared_value_ids;
+    }
+
+    for (auto component_type : archetype.component_types()) {
+        if (!m_shared_components.contains(component_type)) {
+            continue;
         }
-        EntityContainerId container_id;
-        if (m_free_container_ids.empty()) {
-            container_id = m_last_container_id++;
+
+        if (src_container != nullptr && src_container->has_shared_component(component_type)) {
+            shared_value_ids.push_back(src_container->shared_value_id(component_type));
         } else {
-            container_id = m_free_container_ids.back();
-            m_free_container_ids.pop_back();
+            shared_value_ids.push_back(DEFAULT_SHARED_VALUE_ID);
+        }
+    }
+    return shared_value_ids;
+}
+
+std::vector<SharedValueId> EntityDatabaseImpl::fetch_or_init_shared_value_ids(const EntityBuilder& entity_builder)
+{
+    const auto& archetype{ entity_builder.archetype() };
+    auto shared_value_ids{ this->shared_value_ids(archetype, nullptr) };
+    if (shared_value_ids.empty()) {
+        return shared_value_ids;
+    }
+
+    // The builder keeps its values, which are copied if they are new.
+    std::size_t shared_idx{ 0 };
+    for (auto component_type : archetype.component_types()) {
+        if (!m_shared_components.contains(component_type)) {
+            continue;
         }
-        auto [pos, res] = m_entity_containers.emplace(
-            std::piecewise_construct, std::forward_as_tuple(container_id), std::forward_as_tuple(archetype, *this));
-        assert(res);
-        m_archetype_map.emplace(archetype, container_id);
-        for (auto component_type : archetype.component_types()) {
-            m_type_associations.try_emplace(component_type).first->second.emplace(container_id);
+
+        auto values{ entity_builder.values() };
+        auto value_pos{ std::find_if(values.begin(), values.end(),
+            [&](const EntityBuilder::ComponentValue& value) { return value.descriptor.id == component_type; }) };
+        if (value_pos != values.end()) {
+            shared_value_ids[shared_idx] = fetch_or_init_shared_value_copy(component_type, value_pos->ptr.get());
         }
+        shared_idx++;
+    }
+    return shared_value_ids;
+}
+
+EntityDatabaseImpl::EntityContainerId EntityDatabaseImpl::fetch_or_init_entity_container(
+    const EntityArchetype& archetype, std::span<const SharedValueId> shared_value_ids)
+{
+    ContainerKey container_key{ archetype.signature(), { shared_value_ids.begin(), shared_value_ids.end() } };
+    if (auto pos{ m_container_map.find(container_key) }; pos != m_container_map.end()) {
         return pos->second;
+    } else {
+        assert(has_components(archetype));
+        auto container_id{ m_entity_containers.size() };
+        m_entity_containers.push_back(
+            std::make_unique<EntityContainer>(archetype, *this, m_chunk_byte_budget, shared_value_ids));
+        m_container_signatures.push_back(archetype.signature());
+        m_container_map.emplace(std::move(container_key), container_id);
+
+        // Containers are never released, so the cached query plans only have to learn about new archetypes.
+        std::scoped_lock lock{ m_query_mutex };
+        for (auto& query_cache : m_query_caches) {
+            if (query_cache.container_query.matches(archetype.signature())) {
+                query_cache.container_ids.push_back(container_id);
+            }
+        }
+        return container_id;
     }
 }
 
+EntityDatabaseImpl::EntityContainerId EntityDatabaseImpl::fetch_or_init_add_edge(
+    EntityContainerId container_id, ComponentType component_type)
+{
+    auto& entity_container{ *m_entity_containers[container_id] };
+    if (auto edge{ entity_container.fetch_add_edge(component_type) }) {
+        return *edge;
+    }
+
+    auto dst_container_id{ container_id };
+    if (!entity_container.has_component(component_type)) {
+        auto archetype{ entity_container.archetype().with(component_type) };
+        dst_container_id
+            = fetch_or_init_entity_container(archetype, shared_value_ids(archetype, &entity_container));
+
+        // The edges of shared components are one-sided, the destination may already lead back here, see
+        // `fetch_or_init_remove_edge`.
+        auto& dst_container{ *m_entity_containers[dst_container_id] };
+        if (auto dst_edge{ dst_container.fetch_remove_edge(component_type) }) {
+            assert(*dst_edge == container_id);
+        } else {
+            dst_container.insert_remove_edge(component_type, container_id);
+        }
+    }
+    entity_container.insert_add_edge(component_type, dst_container_id);
+    return dst_container_id;
+}
+
+EntityDatabaseImpl::EntityContainerId EntityDatabaseImpl::fetch_or_init_remove_edge(
+    EntityContainerId container_id, ComponentType component_type)
+{
+    auto& entity_container{ *m_entity_containers[container_id] };
+    if (auto edge{ entity_container.fetch_remove_edge(component_type) }) {
+        return *edge;
+    }
+
+    auto dst_container_id{ container_id };
+    if (entity_container.has_component(component_type)) {
+        auto archetype{ entity_container.archetype().without(component_type) };
+        dst_container_id
+            = fetch_or_init_entity_container(archetype, shared_value_ids(archetype, &entity_container));
+
+        // Adding the shared component back starts with its default value, instead of returning to this container.
+        auto& dst_container{ *m_entity_containers[dst_container_id] };
+        if (!m_shared_components.contains(component_type) && !dst_container.fetch_add_edge(component_type)) {
+            dst_container.insert_add_edge(component_type, container_id);
+        }
+    }
+    entity_container.insert_remove_edge(component_type, dst_container_id);
+    return dst_container_id;
+}
+
+std::size_t EntityDatabaseImpl::ContainerKeyHasher::operator()(const ContainerKey& k) const
+{
+    auto hash{ k.signature.hash() };
+    for (auto value_id : k.shared_value_ids) {
+        hash = (hash ^ value_id) * 0x9E3779B97F4A7C15ull;
+    }
+    return hash;
+}
+
 /**************************************************************************************************
  ***************************************** EntityDatabase *****************************************
  **************************************************************************************************/
 
+EntityDatabase::EntityDatabase(std::size_t chunk_byte_budget)
+    : m_context_mutex{}
+    , m_database_impl{ chunk_byte_budget }
+    , m_command_buffer_mutex{}
+    , m_command_buffer{}
+    , m_sync_point{ 0 }
+    , m_created_entities{}
+    , m_auto_compaction_idle_sync_points{ 0 }
+    , m_idle_sync_points{ 0 }
+{
+}
+
 EntityDatabase::~EntityDatabase() noexcept { std::scoped_lock lock{ m_context_mutex }; }
 
+EntityCommandBufferTicket EntityDatabase::submit_command_buffer(EntityCommandBuffer&& command_buffer)
+{
+    std::scoped_lock lock{ m_command_buffer_mutex };
+    // The placeholders of the appended buffer are offset by the ones queued before it.
+    EntityCommandBufferTicket ticket{ m_sync_point, m_command_buffer.deferred_entity_count() };
+    m_command_buffer.append(std::move(command_buffer));
+    return ticket;
+}
+
+std::vector<Entity> EntityDatabase::play_back_command_buffers()
+{
+    EntityCommandBuffer command_buffer{};
+    {
+        std::scoped_lock lock{ m_command_buffer_mutex };
+        command_buffer = std::move(m_command_buffer);
+    }
+
+    std::vector<Entity> created_entities{};
+    if (!command_buffer.empty()) {
+        m_idle_sync_points = 0;
+        // The commands must be newer than the versions seen by the systems of the finished pass.
+        increment_global_version();
+        enter_secure_context([&](EntityDatabaseContext& database_context) {
+            created_entities = command_buffer.play_back(database_context);
+        });
+    } else if (++m_idle_sync_points == m_auto_compaction_idle_sync_points) {
+        compact();
+    }
+
+    {
+        std::scoped_lock lock{ m_command_buffer_mutex };
+        m_created_entities = created_entities;
+        m_sync_point++;
+    }
+
+    // The changes of the commands are published together with the ones recorded by the systems.
+    std::scoped_lock lock{ m_context_mutex };
+    m_database_impl.publish_observations();
+    return created_entities;
+}
+
+Entity EntityDatabase::resolve_entity(const EntityCommandBufferTicket& ticket, Entity placeholder) const
+{
+    assert(EntityCommandBuffer::is_deferred(placeholder));
+    std::scoped_lock lock{ m_command_buffer_mutex };
+    assert(ticket.sync_point + 1 == m_sync_point);
+    assert(ticket.entity_offset + placeholder.id < m_created_entities.size());
+    return m_created_entities[ticket.entity_offset + placeholder.id];
+}
+
+EntityCompactionStatistics EntityDatabase::compact()
+{
+    std::scoped_lock lock{ m_context_mutex };
+    return m_database_impl.compact();
+}
+
+void EntityDatabase::set_auto_compaction(std::size_t idle_sync_points)
+{
+    m_auto_compaction_idle_sync_points = idle_sync_points;
+    m_idle_sync_points = 0;
+}
+
+std::size_t EntityDatabase::global_version() const { return m_database_impl.global_version(); }
+
+std::size_t EntityDatabase::increment_global_version() { return m_database_impl.increment_global_version(); }
+
 /**************************************************************************************************
  ************************************* EntityDatabaseContext *************************************
  **************************************************************************************************/
@@ -501,6 +1589,16 @@ Entity EntityDatabaseContext::init_entity(const EntityBuilder& entity_builder)
     return m_database.init_entity(entity_builder);
 }
 
+EntityRange EntityDatabaseContext::init_entities(const EntityArchetype& archetype, std::size_t count)
+{
+    return m_database.init_entities(archetype, count);
+}
+
+EntityRange EntityDatabaseContext::init_entities(const EntityBuilder& entity_builder, std::size_t count)
+{
+    return m_database.init_entities(entity_builder, count);
+}
+
 Entity EntityDatabaseContext::init_entity_copy(Entity entity, const EntityArchetype& archetype)
 {
     return m_database.init_entity_copy(entity, archetype);
@@ -508,6 +1606,11 @@ Entity EntityDatabaseContext::init_entity_copy(Entity entity, const EntityArchet
 
 void EntityDatabaseContext::erase_entity(Entity entity) { m_database.erase_entity(entity); }
 
+void EntityDatabaseContext::erase_entity_recursive(Entity entity, ComponentType component_type)
+{
+    m_database.erase_entity_recursive(entity, component_type);
+}
+
 void EntityDatabaseContext::move_entity(Entity entity, const EntityArchetype& archetype)
 {
     m_database.move_entity(entity, archetype);
@@ -555,7 +1658,7 @@ void* EntityDatabaseContext::fetch_component_unchecked(Entity entity, ComponentT
 
 const void* EntityDatabaseContext::fetch_component_unchecked(Entity entity, ComponentType component_type) const
 {
-    return m_database.fetch_component_unchecked(entity, component_type);
+    return std::as_const(m_database).fetch_component_unchecked(entity, component_type);
 }
 
 EntityContainer& EntityDatabaseContext::fetch_entity_container(Entity entity)
@@ -573,11 +1676,69 @@ EntityArchetype EntityDatabaseContext::fetch_entity_archetype(Entity entity) con
     return m_database.fetch_entity_archetype(entity);
 }
 
+std::size_t EntityDatabaseContext::fetch_component_version(Entity entity, ComponentType component_type) const
+{
+    return m_database.fetch_component_version(entity, component_type);
+}
+
+bool EntityDatabaseContext::is_component_enabled(Entity entity, ComponentType component_type) const
+{
+    return m_database.is_component_enabled(entity, component_type);
+}
+
+void EntityDatabaseContext::set_component_enabled(Entity entity, ComponentType component_type, bool enabled)
+{
+    m_database.set_component_enabled(entity, component_type, enabled);
+}
+
+RelatedEntities EntityDatabaseContext::fetch_related_entities(Entity entity, ComponentType component_type) const
+{
+    return m_database.fetch_related_entities(entity, component_type);
+}
+
+std::size_t EntityDatabaseContext::global_version() const { return m_database.global_version(); }
+
+std::size_t EntityDatabaseContext::archetype_count() const { return m_database.archetype_count(); }
+
+bool EntityDatabaseContext::queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const
+{
+    return m_database.queries_intersect(lhs, rhs);
+}
+
+EntityCompactionStatistics EntityDatabaseContext::compact() { return m_database.compact(); }
+
+EntityObserverId EntityDatabaseContext::register_observer(ComponentType component_type)
+{
+    return m_database.register_observer(component_type);
+}
+
+EntityObservation EntityDatabaseContext::take_observation(EntityObserverId observer_id)
+{
+    return m_database.take_observation(observer_id);
+}
+
+EntityDBQueryId EntityDatabaseContext::register_query(const EntityDBQuery& query)
+{
+    return m_database.register_query(query);
+}
+
+EntityDBWindow EntityDatabaseContext::query_db_window(EntityDBQueryId query_id)
+{
+    return m_database.query_db_window(query_id);
+}
+
+EntityDBWindow EntityDatabaseContext::query_db_window(EntityDBQuery& query) { return m_database.query_db_window(query); }
+
 EntityDBWindow EntityDatabaseContext::query_db_window(const EntityDBQuery& query)
 {
     return m_database.query_db_window(query);
 }
 
+EntityDBWindow EntityDatabaseContext::query_db_window(const EntityRange& entities)
+{
+    return m_database.query_db_window(entities);
+}
+
 /**************************************************************************************************
  *********************************** EntityDatabaseLazyContext ***********************************
  **************************************************************************************************/
@@ -606,11 +1767,14 @@ void EntityDatabaseLazyContext::read_component(Entity entity, ComponentType comp
 
 void EntityDatabaseLazyContext::write_component_move(Entity entity, ComponentType component_type, void* src)
 {
+    // Writing a shared component moves the entity, which requires exclusive access.
+    assert(!m_database.fetch_component_desc(component_type).shared);
     m_database.write_component_move(entity, component_type, src);
 }
 
 void EntityDatabaseLazyContext::write_component_copy(Entity entity, ComponentType component_type, const void* src)
 {
+    assert(!m_database.fetch_component_desc(component_type).shared);
     m_database.write_component_copy(entity, component_type, src);
 }
 
@@ -621,7 +1785,7 @@ void* EntityDatabaseLazyContext::fetch_component_unchecked(Entity entity, Compon
 
 const void* EntityDatabaseLazyContext::fetch_component_unchecked(Entity entity, ComponentType component_type) const
 {
-    return m_database.fetch_component_unchecked(entity, component_type);
+    return std::as_const(m_database).fetch_component_unchecked(entity, component_type);
 }
 
 EntityArchetype EntityDatabaseLazyContext::fetch_entity_archetype(Entity entity) const
@@ -629,4 +1793,58 @@ EntityArchetype EntityDatabaseLazyContext::fetch_entity_archetype(Entity entity)
     return m_database.fetch_entity_archetype(entity);
 }
 
+std::size_t EntityDatabaseLazyContext::fetch_component_version(Entity entity, ComponentType component_type) const
+{
+    return m_database.fetch_component_version(entity, component_type);
+}
+
+bool EntityDatabaseLazyContext::is_component_enabled(Entity entity, ComponentType component_type) const
+{
+    return m_database.is_component_enabled(entity, component_type);
+}
+
+void EntityDatabaseLazyContext::set_component_enabled(Entity entity, ComponentType component_type, bool enabled)
+{
+    m_database.set_component_enabled(entity, component_type, enabled);
+}
+
+RelatedEntities EntityDatabaseLazyContext::fetch_related_entities(Entity entity, ComponentType component_type) const
+{
+    return m_database.fetch_related_entities(entity, component_type);
+}
+
+std::size_t EntityDatabaseLazyContext::global_version() const { return m_database.global_version(); }
+
+std::size_t EntityDatabaseLazyContext::archetype_count() const { return m_database.archetype_count(); }
+
+bool EntityDatabaseLazyContext::queries_intersect(const EntityDBQuery& lhs, const EntityDBQuery& rhs) const
+{
+    return m_database.queries_intersect(lhs, rhs);
+}
+
+EntityObservation EntityDatabaseLazyContext::take_observation(EntityObserverId observer_id)
+{
+    return m_database.take_observation(observer_id);
+}
+
+EntityDBQueryId EntityDatabaseLazyContext::register_query(const EntityDBQuery& query)
+{
+    return m_database.register_query(query);
+}
+
+EntityDBWindow EntityDatabaseLazyContext::query_db_window(EntityDBQueryId query_id)
+{
+    return m_database.query_db_window(query_id);
+}
+
+EntityDBWindow EntityDatabaseLazyContext::query_db_window(EntityDBQuery& query)
+{
+    return m_database.query_db_window(query);
+}
+
+EntityDBWindow EntityDatabaseLazyContext::query_db_window(const EntityDBQuery& query)
+{
+    return m_database.query_db_window(query);
+}
+
 }
\ No newline at end of file
@@ -18,6 +18,7 @@ namespace Visualizer {
 
 FixedCameraMovementSystem::FixedCameraMovementSystem()
     : m_current_time{ glfwGetTime() }
+    , m_input{}
     , m_camera_query{ EntityDBQuery{}.with_component<Camera, FixedCamera, Transform>() }
     , m_entity_database{}
 {
@@ -49,19 +50,20 @@ glm::quat safeQuatLookAt(
     }
 }
 
-void FixedCameraMovementSystem::run(void*)
+void FixedCameraMovementSystem::prepare()
 {
-    if (isDetached()) {
+    m_input.active = !isDetached();
+    if (!m_input.active) {
         return;
     }
 
     auto window{ glfwGetCurrentContext() };
-    auto w_key{ glfwGetKey(window, GLFW_KEY_W) };
-    auto a_key{ glfwGetKey(window, GLFW_KEY_A) };
-    auto s_key{ glfwGetKey(window, GLFW_KEY_S) };
-    auto d_key{ glfwGetKey(window, GLFW_KEY_D) };
-    auto q_key{ glfwGetKey(window, GLFW_KEY_Q) };
-    auto e_key{ glfwGetKey(window, GLFW_KEY_E) };
+    m_input.w_key = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    m_input.a_key = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    m_input.s_key = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    m_input.d_key = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    m_input.q_key = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+    m_input.e_key = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
 
     auto shift_key{ glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) };
     auto ctrl_key{ glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) };
@@ -69,14 +71,31 @@ void FixedCameraMovementSystem::run(void*)
     auto delta_time{ static_cast<float>(new_time - m_current_time) };
     m_current_time = new_time;
 
-    auto movement_speed{ 1 * delta_time };
+    m_input.movement_speed = 1 * delta_time;
     if (shift_key == GLFW_PRESS) {
-        movement_speed *= 10 * 10.0f;
+        m_input.movement_speed *= 10 * 10.0f;
     } else if (ctrl_key) {
-        movement_speed *= 10;
+        m_input.movement_speed *= 10;
     }
+}
+
+SystemAccess FixedCameraMovementSystem::access() const
+{
+    // The focus may be any entity.
+    SystemAccess access{};
+    access.write<Camera, FixedCamera, Transform>(m_camera_query).read<Transform, Parent>(EntityDBQuery{});
+    return access;
+}
+
+void FixedCameraMovementSystem::run(void*)
+{
+    if (!m_input.active) {
+        return;
+    }
+
+    auto movement_speed{ m_input.movement_speed };
 
-    m_entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+    m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
         auto fixed_cameras{
             m_camera_query.query_db_window(database_context)
                 .filter<Camera, FixedCamera, Transform>(
@@ -91,39 +110,39 @@ void FixedCameraMovementSystem::run(void*)
         perspective_cameras.for_each<Camera, FixedCamera, Transform>(
             [&](const Camera* camera, FixedCamera* fixed_camera, Transform* transform) {
                 if (camera->m_active) {
-                    if (w_key == GLFW_PRESS) {
+                    if (m_input.w_key) {
                         fixed_camera->verticalAngle -= movement_speed;
                         if (fixed_camera->verticalAngle <= glm::radians(3.0f)) {
                             fixed_camera->verticalAngle = glm::radians(3.0f);
                         }
                     }
 
-                    if (s_key == GLFW_PRESS) {
+                    if (m_input.s_key) {
                         fixed_camera->verticalAngle += movement_speed;
                         if (fixed_camera->verticalAngle >= glm::radians(177.0f)) {
                             fixed_camera->verticalAngle = glm::radians(177.0f);
                         }
                     }
 
-                    if (a_key == GLFW_PRESS) {
+                    if (m_input.a_key) {
                         fixed_camera->horizontalAngle -= movement_speed;
                         if (fixed_camera->horizontalAngle <= 0) {
                             fixed_camera->horizontalAngle += 2 * glm::pi<float>();
                         }
                     }
 
-                    if (d_key == GLFW_PRESS) {
+                    if (m_input.d_key) {
                         fixed_camera->horizontalAngle += movement_speed;
                         if (fixed_camera->horizontalAngle >= 2 * glm::pi<float>()) {
                             fixed_camera->horizontalAngle -= 2 * glm::pi<float>();
                         }
                     }
 
-                    if (q_key == GLFW_PRESS) {
+                    if (m_input.q_key) {
                         fixed_camera->distance += movement_speed;
                     }
 
-                    if (e_key == GLFW_PRESS) {
+                    if (m_input.e_key) {
                         fixed_camera->distance -= movement_speed;
                         if (fixed_camera->distance <= 0.0005f) {
                             fixed_camera->distance = 0.0005f;
@@ -131,14 +150,13 @@ void FixedCameraMovementSystem::run(void*)
                     }
                 }
 
-                auto model_matrix{ getModelMatrix(
-                    database_context.fetch_component_unchecked<Transform>(fixed_camera->focus)) };
+                // The focus is only read, which leaves its chunks unchanged.
+                auto model_matrix{ getModelMatrix(database_context.read_component<Transform>(fixed_camera->focus)) };
 
                 for (auto parent_entity{ fixed_camera->focus };
                      database_context.entity_has_component<Parent>(parent_entity);) {
-                    const auto& parent{ database_context.fetch_component_unchecked<Parent>(parent_entity) };
-                    model_matrix
-                        = getModelMatrix(database_context.fetch_component_unchecked<Transform>(parent.m_parent));
+                    auto parent{ database_context.read_component<Parent>(parent_entity) };
+                    model_matrix = getModelMatrix(database_context.read_component<Transform>(parent.m_parent));
                     parent_entity = parent.m_parent;
                 }
 
@@ -167,11 +185,11 @@ void FixedCameraMovementSystem::run(void*)
                 fixed_camera->horizontalAngle = 0.0f;
                 fixed_camera->verticalAngle = glm::pi<float>() / 2;
 
-                if (q_key == GLFW_PRESS) {
+                if (m_input.q_key) {
                     fixed_camera->distance += movement_speed;
                 }
 
-                if (e_key == GLFW_PRESS) {
+                if (m_input.e_key) {
                     fixed_camera->distance -= movement_speed;
                     if (fixed_camera->distance <= 0.0005f) {
                         fixed_camera->distance = 0.0005f;
@@ -179,13 +197,12 @@ void FixedCameraMovementSystem::run(void*)
                 }
             }
 
-            auto model_matrix{ getModelMatrix(
-                database_context.fetch_component_unchecked<Transform>(fixed_camera->focus)) };
+            auto model_matrix{ getModelMatrix(database_context.read_component<Transform>(fixed_camera->focus)) };
 
             for (auto parent_entity{ fixed_camera->focus };
                  database_context.entity_has_component<Parent>(parent_entity);) {
-                const auto& parent{ database_context.fetch_component_unchecked<Parent>(parent_entity) };
-                model_matrix = getModelMatrix(database_context.fetch_component_unchecked<Transform>(parent.m_parent));
+                auto parent{ database_context.read_component<Parent>(parent_entity) };
+                model_matrix = getModelMatrix(database_context.read_component<Transform>(parent.m_parent));
                 parent_entity = parent.m_parent;
             }
 
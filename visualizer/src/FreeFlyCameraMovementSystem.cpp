@@ -22,6 +22,7 @@ FreeFlyCameraMovementSystem::FreeFlyCameraMovementSystem()
     , m_movement_speed{ 10.0f }
     , m_rotation_speed{ 0.005f }
     , m_movement_multiplier{ 1.5f }
+    , m_input{}
     , m_camera_query{ EntityDBQuery{}.with_component<Camera, FreeFly, Transform>() }
     , m_entity_database{}
 {
@@ -32,19 +33,20 @@ void FreeFlyCameraMovementSystem::initialize() { m_entity_database = m_world->ge
 
 void FreeFlyCameraMovementSystem::terminate() { m_entity_database = nullptr; }
 
-void FreeFlyCameraMovementSystem::run(void*)
+void FreeFlyCameraMovementSystem::prepare()
 {
-    if (isDetached()) {
+    m_input.active = !isDetached();
+    if (!m_input.active) {
         return;
     }
 
     auto window{ glfwGetCurrentContext() };
-    auto w_key{ glfwGetKey(window, GLFW_KEY_W) };
-    auto a_key{ glfwGetKey(window, GLFW_KEY_A) };
-    auto s_key{ glfwGetKey(window, GLFW_KEY_S) };
-    auto d_key{ glfwGetKey(window, GLFW_KEY_D) };
-    auto q_key{ glfwGetKey(window, GLFW_KEY_Q) };
-    auto e_key{ glfwGetKey(window, GLFW_KEY_E) };
+    m_input.w_key = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    m_input.a_key = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    m_input.s_key = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    m_input.d_key = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    m_input.q_key = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+    m_input.e_key = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
 
     auto shift_key{ glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) };
     auto ctrl_key{ glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) };
@@ -52,11 +54,11 @@ void FreeFlyCameraMovementSystem::run(void*)
     auto delta_time{ static_cast<float>(new_time - m_current_time) };
     m_current_time = new_time;
 
-    auto movement_speed{ m_movement_speed * delta_time };
+    m_input.movement_speed = m_movement_speed * delta_time;
     if (shift_key == GLFW_PRESS) {
-        movement_speed *= m_movement_multiplier * 10.0f;
+        m_input.movement_speed *= m_movement_multiplier * 10.0f;
     } else if (ctrl_key) {
-        movement_speed *= m_movement_multiplier;
+        m_input.movement_speed *= m_movement_multiplier;
     }
 
     double mouse_x{ 0.0 };
@@ -67,13 +69,30 @@ void FreeFlyCameraMovementSystem::run(void*)
     m_mouse_x = mouse_x;
     m_mouse_y = mouse_y;
 
+    m_input.mouse_rotation = { m_rotation_speed * mouse_y_offset, m_rotation_speed * mouse_x_offset, 0.0 };
+}
+
+SystemAccess FreeFlyCameraMovementSystem::access() const
+{
+    SystemAccess access{};
+    access.read<FreeFly>(m_camera_query).write<Camera, Transform>(m_camera_query);
+    return access;
+}
+
+void FreeFlyCameraMovementSystem::run(void*)
+{
+    if (!m_input.active) {
+        return;
+    }
+
+    auto movement_speed{ m_input.movement_speed };
+    auto mouse_rotation{ m_input.mouse_rotation };
+
     constexpr glm::vec3 forward{ 0.0f, 0.0f, 1.0f };
     constexpr glm::vec3 right{ 1.0f, 0.0f, 0.0f };
     constexpr glm::vec3 up{ 0.0f, 1.0f, 0.0f };
 
-    glm::vec3 mouse_rotation{ m_rotation_speed * mouse_y_offset, m_rotation_speed * mouse_x_offset, 0.0 };
-
-    m_entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+    m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
         auto activeFreeCameras{ m_camera_query.query_db_window(database_context)
                                     .filter<Camera, Transform>([](const Camera* camera, const Transform*) -> bool {
                                         return camera->m_active && !camera->m_fixed;
@@ -96,24 +115,24 @@ void FreeFlyCameraMovementSystem::run(void*)
             auto rotatedRight{ rotation * right };
             auto rotatedUp{ rotation * up };
 
-            if (w_key == GLFW_PRESS) {
+            if (m_input.w_key) {
                 transform->position -= movement_speed * rotatedForwards;
             }
-            if (s_key == GLFW_PRESS) {
+            if (m_input.s_key) {
                 transform->position += movement_speed * rotatedForwards;
             }
 
-            if (a_key == GLFW_PRESS) {
+            if (m_input.a_key) {
                 transform->position -= movement_speed * rotatedRight;
             }
-            if (d_key == GLFW_PRESS) {
+            if (m_input.d_key) {
                 transform->position += movement_speed * rotatedRight;
             }
 
-            if (q_key == GLFW_PRESS) {
+            if (m_input.q_key) {
                 transform->position -= movement_speed * rotatedUp;
             }
-            if (e_key == GLFW_PRESS) {
+            if (m_input.e_key) {
                 transform->position += movement_speed * rotatedUp;
             }
         });
@@ -121,25 +140,25 @@ void FreeFlyCameraMovementSystem::run(void*)
         orthographicCameras.for_each<Camera, Transform>([&](Camera* camera, Transform* transform) {
             transform->rotation = glm::identity<glm::quat>();
 
-            if (w_key == GLFW_PRESS) {
+            if (m_input.w_key) {
                 transform->position += movement_speed * up;
             }
-            if (s_key == GLFW_PRESS) {
+            if (m_input.s_key) {
                 transform->position -= movement_speed * up;
             }
 
-            if (a_key == GLFW_PRESS) {
+            if (m_input.a_key) {
                 transform->position -= movement_speed * right;
             }
-            if (d_key == GLFW_PRESS) {
+            if (m_input.d_key) {
                 transform->position += movement_speed * right;
             }
 
-            if (q_key == GLFW_PRESS) {
+            if (m_input.q_key) {
                 camera->orthographicWidth += movement_speed;
                 camera->orthographicHeight = camera->orthographicWidth / camera->aspect;
             }
-            if (e_key == GLFW_PRESS) {
+            if (m_input.e_key) {
                 camera->orthographicWidth -= movement_speed;
                 camera->orthographicHeight = camera->orthographicWidth / camera->aspect;
 
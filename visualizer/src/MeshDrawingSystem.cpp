@@ -1,25 +1,36 @@
 #include <visualizer/MeshDrawingSystem.hpp>
 
+#include <algorithm>
 #include <memory>
+#include <span>
+#include <utility>
 
 #include <visualizer/Camera.hpp>
 #include <visualizer/Mesh.hpp>
-#include <visualizer/Parent.hpp>
 #include <visualizer/Shader.hpp>
 #include <visualizer/Transform.hpp>
 
 namespace Visualizer {
 
 MeshDrawingSystem::MeshDrawingSystem()
-    : m_mesh_query{ EntityDBQuery{}.with_component<std::shared_ptr<Mesh>, Material, Transform, RenderLayer>() }
-    , m_camera_query{ EntityDBQuery{}.with_component<Camera, Transform>() }
+    : m_mesh_query{ EntityDBQuery{}.with_component<std::shared_ptr<Mesh>, Material, LocalToWorld, RenderLayer>() }
+    , m_camera_query{}
+    , m_draw_batches{}
+    , m_previous_draw_batches{}
+    , m_draw_list{}
     , m_entity_database{}
 {
 }
 
 void MeshDrawingSystem::initialize() { m_entity_database = m_world->getManager<EntityDatabase>(); }
 
-void MeshDrawingSystem::terminate() { m_entity_database = nullptr; }
+void MeshDrawingSystem::terminate()
+{
+    m_entity_database = nullptr;
+    m_draw_batches.clear();
+    m_previous_draw_batches.clear();
+    m_draw_list.clear();
+}
 
 void MeshDrawingSystem::run(void*)
 {
@@ -32,100 +43,92 @@ void MeshDrawingSystem::run(void*)
     glDepthFunc(GL_NOTEQUAL);
 
     m_entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
-        auto drawable_meshes{ m_mesh_query.query_db_window(database_context) };
-
-        m_camera_query.query_db_window(database_context)
-            .for_each<Camera, Transform>([&](Camera* camera, Transform* transform) {
-                camera->m_renderTargets["cube"]->bind(FramebufferBinding::ReadWrite);
-                auto camera_viewport{ camera->m_renderTargets["cube"]->viewport() };
-
-                if (camera->m_active) {
-                    glClearColor(0.4f, 0.05f, 0.05f, 1.0f);
-                } else {
-                    glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+        update_draw_list(database_context);
+
+        m_camera_query.for_each(database_context, [&](Camera& camera, const Transform& transform) {
+            camera.m_renderTargets["cube"]->bind(FramebufferBinding::ReadWrite);
+            auto camera_viewport{ camera.m_renderTargets["cube"]->viewport() };
+
+            if (camera.m_active) {
+                glClearColor(0.4f, 0.05f, 0.05f, 1.0f);
+            } else {
+                glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            }
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(camera_viewport.x + 10, camera_viewport.y + 10, camera_viewport.width - 20,
+                camera_viewport.height - 20);
+            glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            auto view_matrix{ glm::identity<glm::mat4>() };
+            view_matrix = glm::toMat4(glm::inverse(transform.rotation))
+                * glm::translate(view_matrix, -transform.position);
+
+            auto projection_matrix{ glm::identity<glm::mat4>() };
+            if (camera.perspective) {
+                projection_matrix = glm::perspective(camera.fov, camera.aspect, camera.near, camera.far);
+            } else {
+                projection_matrix = glm::ortho(-camera.orthographicWidth / 2.0f, camera.orthographicWidth / 2.0f,
+                    -camera.orthographicHeight / 2.0f, camera.orthographicHeight / 2.0f, -camera.far / 2.0f,
+                    camera.far / 2.0f);
+            }
+            auto view_projection_matrix = projection_matrix * view_matrix;
+
+            ShaderEnvironment camera_variables{};
+            std::shared_ptr<ShaderProgram> last_program{ nullptr };
+
+            // The material and the mesh are only bound again when consecutive entities belong to different batches.
+            const DrawBatch* bound_batch{ nullptr };
+            Mesh* mesh{ nullptr };
+            for (const auto& draw_command : m_draw_list) {
+                const auto& draw_batch{ m_draw_batches[draw_command.batch_idx] };
+                if (!(draw_batch.any_layers & camera.m_visibleLayers)) {
+                    continue;
                 }
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-                glEnable(GL_SCISSOR_TEST);
-                glScissor(camera_viewport.x + 10, camera_viewport.y + 10, camera_viewport.width - 20,
-                    camera_viewport.height - 20);
-                glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-                auto view_matrix{ glm::identity<glm::mat4>() };
-                view_matrix = glm::toMat4(glm::inverse(transform->rotation))
-                    * glm::translate(view_matrix, -transform->position);
-
-                auto projection_matrix{ glm::identity<glm::mat4>() };
-                if (camera->perspective) {
-                    projection_matrix = glm::perspective(camera->fov, camera->aspect, camera->near, camera->far);
-                } else {
-                    projection_matrix = glm::ortho(-camera->orthographicWidth / 2.0f, camera->orthographicWidth / 2.0f,
-                        -camera->orthographicHeight / 2.0f, camera->orthographicHeight / 2.0f, -camera->far / 2.0f,
-                        camera->far / 2.0f);
+
+                // The layers of the entities are only tested if some of them are invisible to the camera.
+                auto all_visible{ static_cast<bool>(draw_batch.all_layers & camera.m_visibleLayers) };
+                if (!all_visible && !(draw_batch.layers[draw_command.entity_idx] & camera.m_visibleLayers)) {
+                    continue;
                 }
-                auto view_projection_matrix = projection_matrix * view_matrix;
-
-                ShaderEnvironment camera_variables{};
-                std::shared_ptr<ShaderProgram> last_program{ nullptr };
-
-                std::vector<std::tuple<Entity, const std::shared_ptr<Mesh>*, const Material*, glm::mat4>> mesh_list{};
-
-                drawable_meshes.for_each<const std::shared_ptr<Mesh>, const Material, const Transform,
-                    const RenderLayer>(
-                    [&](Entity entity, const std::shared_ptr<Mesh>* mesh, const Material* material,
-                        const Transform* transform, const RenderLayer*) {
-                        auto model_matrix{ getModelMatrix(*transform) };
-
-                        for (auto parent_entity{ entity };
-                             database_context.entity_has_component<Parent>(parent_entity);) {
-                            const auto& parent{ database_context.fetch_component_unchecked<Parent>(parent_entity) };
-                            model_matrix
-                                = getModelMatrix(database_context.fetch_component_unchecked<Transform>(parent.m_parent))
-                                * model_matrix;
-                            parent_entity = parent.m_parent;
-                        }
-
-                        mesh_list.insert(
-                            std::upper_bound(mesh_list.begin(), mesh_list.end(), entity,
-                                [](const Entity& entity,
-                                    const std::tuple<Entity, const std::shared_ptr<Mesh>*, const Material*, glm::mat4>&
-                                        tup) { return std::get<0>(tup).id > entity.id; }),
-                            { entity, mesh, material, model_matrix });
-                    },
-                    [&](Entity, const std::shared_ptr<Mesh>*, const Material*, const Transform*,
-                        const RenderLayer* layer) -> bool { return (*layer & camera->m_visibleLayers); });
-
-                for (auto& mesh_info : mesh_list) {
-                    auto& mesh{ std::get<1>(mesh_info) };
-                    auto& material{ std::get<2>(mesh_info) };
-                    auto& model_matrix{ std::get<3>(mesh_info) };
-
-                    if (last_program != material->m_shader) {
-                        last_program = material->m_shader;
-                        camera_variables = ShaderEnvironment{ *material->m_shader, ParameterQualifier::Program };
+
+                if (bound_batch != &draw_batch) {
+                    if (mesh != nullptr) {
+                        mesh->unbind();
+                    }
+
+                    const auto& material{ *draw_batch.material };
+                    if (last_program != material.m_shader) {
+                        last_program = material.m_shader;
+                        camera_variables = ShaderEnvironment{ *material.m_shader, ParameterQualifier::Program };
                         camera_variables.set("viewProjectionMatrix", view_projection_matrix);
-                        material->m_shader->bind();
+                        material.m_shader->bind();
                     }
+                    last_program->apply(material.m_materialVariables);
 
-                    camera_variables.set("modelMatrix", model_matrix);
+                    bound_batch = &draw_batch;
+                    mesh = draw_batch.mesh->get();
+                    mesh->bind();
+                }
 
-                    last_program->apply(camera_variables);
-                    last_program->apply(material->m_materialVariables);
+                camera_variables.set("modelMatrix", draw_batch.model_matrices[draw_command.entity_idx].matrix);
+                last_program->apply(camera_variables);
+                glDrawElements(
+                    mesh->primitiveType(), static_cast<GLsizei>(mesh->getIndexCount()), mesh->indexType(), nullptr);
+            }
 
-                    auto tmp{ mesh->get() };
-                    tmp->bind();
-                    glDrawElements(
-                        tmp->primitiveType(), static_cast<GLsizei>(tmp->getIndexCount()), tmp->indexType(), nullptr);
-                    tmp->unbind();
-                }
+            if (mesh != nullptr) {
+                mesh->unbind();
+            }
 
-                if (last_program != nullptr) {
-                    last_program->unbind();
-                }
+            if (last_program != nullptr) {
+                last_program->unbind();
+            }
 
-                glDisable(GL_SCISSOR_TEST);
-            });
+            glDisable(GL_SCISSOR_TEST);
+        });
     });
 
     glBlendFunc(GL_ONE, GL_ZERO);
@@ -134,4 +137,63 @@ void MeshDrawingSystem::run(void*)
     glDisable(GL_BLEND);
 }
 
-}
\ No newline at end of file
+void MeshDrawingSystem::update_draw_list(EntityDatabaseContext& database_context)
+{
+    // The model matrices are kept up to date by the `TransformPropagationSystem`, the batches only reference them.
+    // Entities with a disabled render layer are not part of the window, so hidden entities never reach the batches.
+    // The mesh and the material are shared components, which are the same for all entities of a chunk.
+    // The layer summaries of the previous run are reused for the chunks whose layers were not written since.
+    auto version{ database_context.global_version() };
+    auto drawable_meshes{ m_mesh_query.query_db_window(database_context) };
+    auto layer_idx{ drawable_meshes.component_idx(getComponentType<RenderLayer>()) };
+    std::swap(m_draw_batches, m_previous_draw_batches);
+    m_draw_batches.clear();
+    m_draw_batches.reserve(drawable_meshes.chunk_size());
+    m_draw_list.clear();
+    m_draw_list.reserve(drawable_meshes.size());
+    drawable_meshes.iterate_chunk<const RenderLayer, const LocalToWorld>(
+        [&](std::size_t chunk_idx, std::span<const Entity> entities, std::span<const RenderLayer> layers,
+            std::span<const LocalToWorld> model_matrices) {
+            auto& draw_batch{ m_draw_batches.emplace_back(
+                DrawBatch{ drawable_meshes.fetch_chunk_shared_component<std::shared_ptr<Mesh>>(chunk_idx),
+                    drawable_meshes.fetch_chunk_shared_component<Material>(chunk_idx), layers, model_matrices,
+                    RenderLayer{}, RenderLayer{}, 0 }) };
+            auto previous_batch{ chunk_idx < m_previous_draw_batches.size() ? &m_previous_draw_batches[chunk_idx]
+                                                                            : nullptr };
+            update_layer_summary(
+                draw_batch, previous_batch, drawable_meshes.chunk_version(chunk_idx, layer_idx), version);
+
+            for (std::size_t entity_idx{ 0 }; entity_idx < entities.size(); ++entity_idx) {
+                m_draw_list.push_back({ entities[entity_idx], m_draw_batches.size() - 1, entity_idx });
+            }
+        });
+
+    // The framebuffer is clamped after every draw, so the blending `GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA` depends on
+    // the order of the draws, which must not change with the layout of the chunks.
+    std::sort(m_draw_list.begin(), m_draw_list.end(),
+        [](const DrawCommand& lhs, const DrawCommand& rhs) { return lhs.entity.id < rhs.entity.id; });
+}
+
+void MeshDrawingSystem::update_layer_summary(
+    DrawBatch& draw_batch, const DrawBatch* previous_batch, std::size_t layers_version, std::size_t version) const
+{
+    // The layers of a batch are identified by their range, which changes whenever the entities of the batch change.
+    const auto& layers{ draw_batch.layers };
+    if (previous_batch != nullptr && previous_batch->layers.data() == layers.data()
+        && previous_batch->layers.size() == layers.size() && layers_version <= previous_batch->layers_version) {
+        draw_batch.any_layers = previous_batch->any_layers;
+        draw_batch.all_layers = previous_batch->all_layers;
+        draw_batch.layers_version = previous_batch->layers_version;
+        return;
+    }
+
+    draw_batch.any_layers = RenderLayer{};
+    draw_batch.all_layers = RenderLayer::all();
+    for (const auto& layer : layers) {
+        draw_batch.any_layers |= layer;
+        draw_batch.all_layers &= layer;
+    }
+    draw_batch.layers_version = version;
+}
+
+}
@@ -2,8 +2,12 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
+#include <span>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
 #include <visualizer/ActiveCameraSwitcher.hpp>
@@ -20,9 +24,12 @@
 #include <visualizer/FreeFly.hpp>
 #include <visualizer/FreeFlyCameraMovementSystem.hpp>
 #include <visualizer/Iteration.hpp>
+#include <visualizer/LocalToWorld.hpp>
 #include <visualizer/MeshDrawingSystem.hpp>
 #include <visualizer/Parent.hpp>
 #include <visualizer/SystemManager.hpp>
+#include <visualizer/ThreadPool.hpp>
+#include <visualizer/TransformPropagationSystem.hpp>
 
 namespace Visualizer {
 
@@ -313,11 +320,10 @@ void initialize_asset(const Visconfig::Asset& asset)
 void register_component_descriptors(EntityDatabaseContext& database_context)
 {
     database_context.register_component_desc<Cube>();
-    database_context.register_component_desc<std::shared_ptr<Mesh>>();
-    database_context.register_component_desc<Parent>();
-    database_context.register_component_desc<Material>();
-    database_context.register_component_desc<RenderLayer>();
+    database_context.register_relationship_component_desc<Parent, &Parent::m_parent>();
+    database_context.register_enableable_component_desc<RenderLayer>();
     database_context.register_component_desc<Transform>();
+    database_context.register_component_desc<LocalToWorld>();
     database_context.register_component_desc<HomogeneousIteration>();
     database_context.register_component_desc<EntityActivation>();
     database_context.register_component_desc<MeshIteration>();
@@ -329,10 +335,13 @@ void register_component_descriptors(EntityDatabaseContext& database_context)
     database_context.register_component_desc<Composition>();
     database_context.register_component_desc<Draggable>();
     database_context.register_component_desc<Copy>();
+
+    // Few distinct meshes and materials are shared by many cubes, which are thereby grouped into the same chunks.
+    database_context.register_shared_component_desc<std::shared_ptr<Mesh>>();
+    database_context.register_shared_component_desc<Material>();
 }
 
-void add_entity(EntityDatabaseContext& database_context, std::unordered_map<std::size_t, Entity>& entity_id_map,
-    const Visconfig::Entity& entity)
+EntityArchetype entity_archetype(const Visconfig::Entity& entity)
 {
     EntityArchetype archetype{};
     for (auto& component : entity.components) {
@@ -353,7 +362,8 @@ void add_entity(EntityDatabaseContext& database_context, std::unordered_map<std:
             archetype = archetype.with<RenderLayer>();
             break;
         case Visconfig::Components::ComponentType::Transform:
-            archetype = archetype.with<Transform>();
+            // The matrix is derived from the transforms, see `TransformPropagationSystem`.
+            archetype = archetype.with<Transform, LocalToWorld>();
             break;
         case Visconfig::Components::ComponentType::ImplicitIteration:
             archetype = archetype.with<HomogeneousIteration>();
@@ -391,10 +401,26 @@ void add_entity(EntityDatabaseContext& database_context, std::unordered_map<std:
         }
     }
 
-    const auto [it, success] = entity_id_map.insert({ entity.id, database_context.init_entity(archetype) });
-    if (!success) {
-        std::cerr << "Unable to insert into entity map" << std::endl;
+    return archetype;
+}
+
+bool has_same_components(const Visconfig::Entity& lhs, const Visconfig::Entity& rhs)
+{
+    return std::equal(lhs.components.begin(), lhs.components.end(), rhs.components.begin(), rhs.components.end(),
+        [](const Visconfig::Component& l, const Visconfig::Component& r) { return l.type == r.type; });
+}
+
+EntityRange add_entities(EntityDatabaseContext& database_context,
+    std::unordered_map<std::size_t, Entity>& entity_id_map, std::span<const Visconfig::Entity> entities)
+{
+    auto ecs_entities{ database_context.init_entities(entity_archetype(entities.front()), entities.size()) };
+    for (std::size_t i{ 0 }; i < entities.size(); ++i) {
+        const auto [it, success] = entity_id_map.insert({ entities[i].id, ecs_entities[i] });
+        if (!success) {
+            std::cerr << "Unable to insert into entity map" << std::endl;
+        }
     }
+    return ecs_entities;
 }
 
 void initialize_component(
@@ -1340,85 +1366,94 @@ void initialize_component(
     database_context.write_component(entity, Copy{ std::move(operations) });
 }
 
-void initialize_entity(EntityDatabaseContext& database_context,
-    const std::unordered_map<std::size_t, Entity>& entityIdMap, const Visconfig::Entity& entity)
+void initialize_entity_component(EntityDatabaseContext& database_context,
+    const std::unordered_map<std::size_t, Entity>& entityIdMap, Entity ecs_entity,
+    const Visconfig::Component& component)
 {
-    auto ecs_entity{ entityIdMap.at(entity.id) };
+    switch (component.type) {
+    case Visconfig::Components::ComponentType::Cube:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::CubeComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::Mesh:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::MeshComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::Parent:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::ParentComponent>(component.data), entityIdMap);
+        break;
+    case Visconfig::Components::ComponentType::Material:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::MaterialComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::Layer:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::LayerComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::Transform:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::TransformComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::ImplicitIteration:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::ImplicitIterationComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::ExplicitIteration:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::ExplicitIterationComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::EntityActivation:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::EntityActivationComponent>(component.data),
+            entityIdMap);
+        break;
+    case Visconfig::Components::ComponentType::MeshIteration:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::MeshIterationComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::ExplicitHeterogeneousIteration:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::ExplicitHeterogeneousIterationComponent>(
+                component.data));
+        break;
+    case Visconfig::Components::ComponentType::Camera:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::CameraComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::FreeFlyCamera:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::FreeFlyCameraComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::FixedCamera:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::FixedCameraComponent>(component.data), entityIdMap);
+        break;
+    case Visconfig::Components::ComponentType::CameraSwitcher:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::CameraSwitcherComponent>(component.data),
+            entityIdMap);
+        break;
+    case Visconfig::Components::ComponentType::Composition:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::CompositionComponent>(component.data));
+        break;
+    case Visconfig::Components::ComponentType::Copy:
+        initialize_component(database_context, ecs_entity,
+            *std::static_pointer_cast<const Visconfig::Components::CopyComponent>(component.data));
+        break;
+    }
+}
 
-    for (auto& component : entity.components) {
-        switch (component.type) {
-        case Visconfig::Components::ComponentType::Cube:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::CubeComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::Mesh:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::MeshComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::Parent:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::ParentComponent>(component.data), entityIdMap);
-            break;
-        case Visconfig::Components::ComponentType::Material:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::MaterialComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::Layer:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::LayerComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::Transform:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::TransformComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::ImplicitIteration:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::ImplicitIterationComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::ExplicitIteration:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::ExplicitIterationComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::EntityActivation:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::EntityActivationComponent>(component.data),
-                entityIdMap);
-            break;
-        case Visconfig::Components::ComponentType::MeshIteration:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::MeshIterationComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::ExplicitHeterogeneousIteration:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::ExplicitHeterogeneousIterationComponent>(
-                    component.data));
-            break;
-        case Visconfig::Components::ComponentType::Camera:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::CameraComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::FreeFlyCamera:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::FreeFlyCameraComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::FixedCamera:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::FixedCameraComponent>(component.data),
-                entityIdMap);
-            break;
-        case Visconfig::Components::ComponentType::CameraSwitcher:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::CameraSwitcherComponent>(component.data),
-                entityIdMap);
-            break;
-        case Visconfig::Components::ComponentType::Composition:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::CompositionComponent>(component.data));
-            break;
-        case Visconfig::Components::ComponentType::Copy:
-            initialize_component(database_context, ecs_entity,
-                *std::static_pointer_cast<const Visconfig::Components::CopyComponent>(component.data));
-            break;
+void initialize_entities(EntityDatabaseContext& database_context,
+    const std::unordered_map<std::size_t, Entity>& entityIdMap, std::span<const Visconfig::Entity> entities,
+    const EntityRange& ecs_entities)
+{
+    // The entities share their components, which are initialized column by column.
+    for (std::size_t component_idx{ 0 }; component_idx < entities.front().components.size(); ++component_idx) {
+        for (std::size_t i{ 0 }; i < entities.size(); ++i) {
+            initialize_entity_component(
+                database_context, entityIdMap, ecs_entities[i], entities[i].components[component_idx]);
         }
     }
 }
@@ -1432,15 +1467,28 @@ World initialize_world(const Visconfig::World& world)
 
     entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
         register_component_descriptors(database_context);
-        for (auto& entity : world.entities) {
-            add_entity(database_context, entity_id_map, entity);
+
+        // Consecutive entities with the same components are created together, which preserves their order.
+        std::vector<std::tuple<std::span<const Visconfig::Entity>, EntityRange>> entity_runs{};
+        std::span<const Visconfig::Entity> entities{ world.entities };
+        while (!entities.empty()) {
+            auto run_end{ std::find_if_not(entities.begin() + 1, entities.end(),
+                [&](const Visconfig::Entity& entity) { return has_same_components(entities.front(), entity); }) };
+            auto run{ entities.first(std::distance(entities.begin(), run_end)) };
+            entity_runs.emplace_back(run, add_entities(database_context, entity_id_map, run));
+            entities = entities.subspan(run.size());
         }
 
-        for (auto& entity : world.entities) {
-            initialize_entity(database_context, entity_id_map, entity);
+        for (auto& [run, ecs_entities] : entity_runs) {
+            initialize_entities(database_context, entity_id_map, run, ecs_entities);
         }
     });
 
+    // Writing the shared components moved the entities out of the containers of the default values,
+    // whose chunks are no longer needed.
+    entity_database->compact();
+
+    ecs_world.addManager<ThreadPool>();
     auto systemManager{ ecs_world.addManager<SystemManager>() };
 
     systemManager->addSystem<CubeMovementSystem>("tick"sv);
@@ -1449,6 +1497,7 @@ World initialize_world(const Visconfig::World& world)
     systemManager->addSystem<FreeFlyCameraMovementSystem>("tick"sv);
     systemManager->addSystem<FixedCameraMovementSystem>("tick"sv);
 
+    systemManager->addSystem<TransformPropagationSystem>("draw"sv);
     systemManager->addSystem<MeshDrawingSystem>("draw"sv);
     systemManager->addSystem<CompositingSystem>("composite"sv);
 
@@ -1495,6 +1544,24 @@ void draw(const Scene& scene)
         auto system_manager{ world.getManager<SystemManager>() };
         system_manager->run("composite"sv);
     }
+
+#ifdef LOG_SYSTEM_STATISTICS
+    SystemPassStatistics frame_statistics{};
+    for (auto& world : scene.worlds) {
+        auto system_manager{ world.getManager<SystemManager>() };
+        for (auto pass : { "tick"sv, "draw"sv, "post-process"sv, "composite"sv }) {
+            auto statistics{ system_manager->getStatistics(pass) };
+            frame_statistics.system_count += statistics.system_count;
+            frame_statistics.system_time += statistics.system_time;
+            frame_statistics.wall_time += statistics.wall_time;
+        }
+    }
+
+    std::cout << "Frame: " << frame_statistics.system_count << " systems ran for "
+              << frame_statistics.system_time.count() * 1000.0 << "ms in "
+              << frame_statistics.wall_time.count() * 1000.0 << "ms, parallelism " << frame_statistics.parallelism()
+              << std::endl;
+#endif // LOG_SYSTEM_STATISTICS
 }
 
 }
\ No newline at end of file
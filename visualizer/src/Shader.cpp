@@ -1,6 +1,7 @@
 #include <visualizer/Shader.hpp>
 
 #include <charconv>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <utility>
@@ -307,6 +308,13 @@ std::span<std::string_view> ShaderEnvironment::parameters() const
     return { const_cast<std::string_view*>(m_parameterNames.data()), m_parameterNames.size() };
 }
 
+bool ShaderEnvironment::operator==(const ShaderEnvironment& other) const
+{
+    // Unset parameters are zeroed, so that the padding and the unused parameters compare equal.
+    return m_dataSize == other.m_dataSize && m_parameterInfos == other.m_parameterInfos
+        && (m_dataSize == 0 || std::memcmp(m_parameterData.get(), other.m_parameterData.get(), m_dataSize) == 0);
+}
+
 ShaderEnvironment::~ShaderEnvironment()
 {
     /// TODO: Destruct inners
@@ -0,0 +1,46 @@
+#include <visualizer/SystemAccess.hpp>
+
+#include <visualizer/EntityDatabase.hpp>
+
+namespace Visualizer {
+
+/**************************************************************************************************
+ ****************************************** SystemAccess ******************************************
+ **************************************************************************************************/
+
+SystemAccess SystemAccess::exclusive_access()
+{
+    SystemAccess access{};
+    access.exclusive = true;
+    access.main_thread = true;
+    return access;
+}
+
+bool SystemAccess::conflicts(const SystemAccess& other, const EntityDatabaseLazyContext& database_context) const
+{
+    if (exclusive || other.exclusive) {
+        return true;
+    }
+
+    // The OpenGL state is shared between all main thread systems, so they must keep their order.
+    if (main_thread && other.main_thread) {
+        return true;
+    }
+
+    for (const auto& component : components) {
+        for (const auto& other_component : other.components) {
+            if (component.component_type != other_component.component_type
+                || !(component.write || other_component.write)) {
+                continue;
+            }
+
+            if (database_context.queries_intersect(component.query, other_component.query)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+}
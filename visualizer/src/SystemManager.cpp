@@ -1,5 +1,15 @@
 #include <visualizer/SystemManager.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/ThreadPool.hpp>
+
 namespace Visualizer {
 
 void* SystemParameterMap::retrieve(TypeId typeId) const
@@ -13,6 +23,14 @@ void* SystemParameterMap::retrieve(TypeId typeId) const
 
 void SystemParameterMap::insert(TypeId typeId, void* parameter) { m_parameters.insert_or_assign(typeId, parameter); }
 
+double SystemPassStatistics::parallelism() const
+{
+    if (wall_time.count() <= 0.0) {
+        return 1.0;
+    }
+    return system_time / wall_time;
+}
+
 SystemManager::~SystemManager()
 {
     for (auto& pass : m_passes) {
@@ -61,6 +79,7 @@ void SystemManager::setSystem(std::string_view pass, TypeId typeId, std::shared_
         auto& systemPass{ m_passes[pos->second] };
         systemPass.m_systems.emplace_back(std::move(system), typeId);
         systemPass.m_systemMap.insert_or_assign(typeId, systemPass.m_systems.size() - 1);
+        systemPass.m_schedules.clear();
     } else {
         auto systemPass{ SystemPass{} };
         systemPass.m_systems.emplace_back(std::move(system), typeId);
@@ -74,11 +93,214 @@ void SystemManager::run(std::string_view pass, const SystemParameterMap& paramet
 {
     if (auto pos{ m_passesMap.find(pass) }; pos != m_passesMap.end()) {
         auto& systemPass{ m_passes[pos->second] };
+        auto start{ std::chrono::steady_clock::now() };
 
+        // GLFW may only be queried from the main thread.
         for (auto& system : systemPass.m_systems) {
-            std::get<0>(system)->run(parameters.retrieve(std::get<1>(system)));
+            std::get<0>(system)->prepare();
+        }
+
+        std::chrono::duration<double> systemTime{ 0 };
+        if (!m_world->hasManager<ThreadPool>() || !m_world->hasManager<EntityDatabase>()) {
+            for (std::size_t i{ 0 }; i < systemPass.m_systems.size(); ++i) {
+                systemTime += runSystem(systemPass, i, parameters);
+            }
+        } else {
+            if (systemPass.m_schedules.empty()) {
+                buildSchedules(systemPass);
+            }
+
+            for (auto& schedule : systemPass.m_schedules) {
+                if (schedule.m_exclusive) {
+                    systemTime += runSystem(systemPass, schedule.m_begin, parameters);
+                } else {
+                    updateSchedule(systemPass, schedule);
+                    systemTime += runSchedule(systemPass, schedule, parameters);
+                }
+            }
         }
+
+        // The end of a pass is the sync point for the structural changes recorded by its systems.
+        if (m_world->hasManager<EntityDatabase>()) {
+            m_world->getManager<EntityDatabase>()->play_back_command_buffers();
+        }
+
+        systemPass.m_statistics = SystemPassStatistics{ systemPass.m_systems.size(), systemTime,
+            std::chrono::steady_clock::now() - start };
+    }
+}
+
+SystemPassStatistics SystemManager::getStatistics(std::string_view pass) const
+{
+    if (auto pos{ m_passesMap.find(pass) }; pos != m_passesMap.end()) {
+        return m_passes[pos->second].m_statistics;
+    } else {
+        return SystemPassStatistics{};
+    }
+}
+
+void SystemManager::buildSchedules(SystemPass& systemPass)
+{
+    systemPass.m_schedules.clear();
+
+    // Exclusive systems split the pass into ranges of systems which may run concurrently.
+    for (std::size_t i{ 0 }; i < systemPass.m_systems.size(); ++i) {
+        auto exclusive{ std::get<0>(systemPass.m_systems[i])->access().exclusive };
+        if (exclusive || systemPass.m_schedules.empty() || systemPass.m_schedules.back().m_exclusive) {
+            SystemSchedule schedule{};
+            schedule.m_exclusive = exclusive;
+            schedule.m_begin = i;
+            schedule.m_end = i + 1;
+            schedule.m_archetypeCount = std::numeric_limits<std::size_t>::max();
+            systemPass.m_schedules.push_back(std::move(schedule));
+        } else {
+            systemPass.m_schedules.back().m_end = i + 1;
+        }
+    }
+}
+
+void SystemManager::updateSchedule(SystemPass& systemPass, SystemSchedule& schedule)
+{
+    auto entityDatabase{ m_world->getManager<EntityDatabase>() };
+    entityDatabase->enter_secure_lazy_context([&](EntityDatabaseLazyContext& databaseContext) {
+        auto archetypeCount{ databaseContext.archetype_count() };
+        if (schedule.m_archetypeCount == archetypeCount) {
+            return;
+        }
+
+        auto systemCount{ schedule.m_end - schedule.m_begin };
+        std::vector<SystemAccess> accesses{};
+        accesses.reserve(systemCount);
+        for (auto i{ schedule.m_begin }; i < schedule.m_end; ++i) {
+            accesses.push_back(std::get<0>(systemPass.m_systems[i])->access());
+        }
+
+        schedule.m_archetypeCount = archetypeCount;
+        schedule.m_mainThread.assign(systemCount, false);
+        schedule.m_dependencyCounts.assign(systemCount, 0);
+        schedule.m_dependents.assign(systemCount, {});
+
+        // Conflicting systems keep the order in which they were added.
+        for (std::size_t i{ 0 }; i < systemCount; ++i) {
+            schedule.m_mainThread[i] = accesses[i].main_thread;
+            for (auto j{ i + 1 }; j < systemCount; ++j) {
+                if (accesses[i].conflicts(accesses[j], databaseContext)) {
+                    schedule.m_dependents[i].push_back(j);
+                    schedule.m_dependencyCounts[j]++;
+                }
+            }
+        }
+    });
+}
+
+std::chrono::duration<double> SystemManager::runSystem(
+    const SystemPass& systemPass, std::size_t index, const SystemParameterMap& parameters)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    const auto& [system, typeId]{ systemPass.m_systems[index] };
+
+    // Every run gets its own version, so that a system can detect the changes made after its previous run.
+    if (m_world->hasManager<EntityDatabase>()) {
+        m_world->getManager<EntityDatabase>()->increment_global_version();
+    }
+    system->run(parameters.retrieve(typeId));
+    return std::chrono::steady_clock::now() - start;
+}
+
+std::chrono::duration<double> SystemManager::runSchedule(
+    const SystemPass& systemPass, const SystemSchedule& schedule, const SystemParameterMap& parameters)
+{
+    auto threadPool{ m_world->getManager<ThreadPool>() };
+
+    std::mutex mutex{};
+    std::condition_variable condition{};
+    std::deque<std::size_t> mainThreadSystems{};
+    std::vector<std::size_t> dependencyCounts{ schedule.m_dependencyCounts };
+    std::size_t remainingSystems{ schedule.m_end - schedule.m_begin };
+    std::chrono::duration<double> systemTime{ 0 };
+    std::exception_ptr exception{};
+
+    std::function<void(std::size_t)> runScheduled{};
+    auto dispatch{ [&](const std::vector<std::size_t>& systems) {
+        for (auto system : systems) {
+            threadPool->submit([&, system]() { runScheduled(system); });
+        }
+    } };
+    auto complete{ [&](std::size_t system, std::chrono::duration<double> time, std::exception_ptr error) {
+        std::vector<std::size_t> readySystems{};
+        {
+            std::scoped_lock lock{ mutex };
+            systemTime += time;
+            if (error && !exception) {
+                exception = error;
+            }
+
+            for (auto dependent : schedule.m_dependents[system]) {
+                if (--dependencyCounts[dependent] != 0) {
+                    continue;
+                } else if (schedule.m_mainThread[dependent]) {
+                    mainThreadSystems.push_back(dependent);
+                } else {
+                    readySystems.push_back(dependent);
+                }
+            }
+
+            // The state lives on the stack of the main thread, which may return as soon as the lock is released.
+            --remainingSystems;
+            condition.notify_all();
+        }
+
+        if (!readySystems.empty()) {
+            dispatch(readySystems);
+        }
+    } };
+    runScheduled = [&](std::size_t system) {
+        std::chrono::duration<double> time{ 0 };
+        std::exception_ptr error{};
+        try {
+            time = runSystem(systemPass, schedule.m_begin + system, parameters);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        complete(system, time, error);
+    };
+
+    std::vector<std::size_t> readySystems{};
+    for (std::size_t i{ 0 }; i < dependencyCounts.size(); ++i) {
+        if (dependencyCounts[i] != 0) {
+            continue;
+        } else if (schedule.m_mainThread[i]) {
+            mainThreadSystems.push_back(i);
+        } else {
+            readySystems.push_back(i);
+        }
+    }
+    dispatch(readySystems);
+
+    std::unique_lock lock{ mutex };
+    while (remainingSystems != 0) {
+        if (!mainThreadSystems.empty()) {
+            auto system{ mainThreadSystems.front() };
+            mainThreadSystems.pop_front();
+            lock.unlock();
+            runScheduled(system);
+            lock.lock();
+            continue;
+        }
+
+        // Help out with the pending work, before going to sleep.
+        lock.unlock();
+        auto ranTask{ threadPool->run_pending_task() };
+        lock.lock();
+        if (!ranTask) {
+            condition.wait(lock, [&]() { return remainingSystems == 0 || !mainThreadSystems.empty(); });
+        }
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
     }
+    return systemTime;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <visualizer/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Visualizer {
+
+namespace {
+
+/// Pool and queue of the current thread, if it is a worker thread.
+thread_local const ThreadPool* t_thread_pool{ nullptr };
+thread_local std::size_t t_queue_idx{ 0 };
+
+}
+
+/**************************************************************************************************
+ ******************************************* ThreadPool *******************************************
+ **************************************************************************************************/
+
+ThreadPool::ThreadPool()
+    : ThreadPool{ std::max(std::thread::hardware_concurrency(), 1u) - 1 }
+{
+}
+
+ThreadPool::ThreadPool(std::size_t worker_count)
+    : m_stop{ false }
+    , m_pending_tasks{ 0 }
+    , m_next_queue{ 0 }
+    , m_sleep_mutex{}
+    , m_sleep_condition{}
+    , m_queues{}
+    , m_workers{}
+{
+    m_queues.reserve(worker_count);
+    for (std::size_t i{ 0 }; i < worker_count; ++i) {
+        m_queues.push_back(std::make_unique<TaskQueue>());
+    }
+
+    m_workers.reserve(worker_count);
+    for (std::size_t i{ 0 }; i < worker_count; ++i) {
+        m_workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock{ m_sleep_mutex };
+        m_stop = true;
+    }
+    m_sleep_condition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::worker_count() const { return m_queues.size(); }
+
+void ThreadPool::submit(Task task) { submit(std::move(task), nullptr); }
+
+bool ThreadPool::run_pending_task() { return run_pending_task(nullptr); }
+
+void ThreadPool::submit(Task task, TaskGroup group)
+{
+    if (worker_count() == 0) {
+        task();
+        return;
+    }
+
+    // Workers push onto their own queue, all other threads distribute the tasks round-robin.
+    auto queue_idx{ t_thread_pool == this ? t_queue_idx
+                                          : m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size() };
+
+    // Count the task before it becomes visible, so that the counter never drops below zero.
+    {
+        std::scoped_lock lock{ m_sleep_mutex };
+        m_pending_tasks.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::scoped_lock lock{ m_queues[queue_idx]->mutex };
+        m_queues[queue_idx]->tasks.push_back(GroupedTask{ std::move(task), group });
+    }
+    m_sleep_condition.notify_one();
+}
+
+bool ThreadPool::run_pending_task(TaskGroup group)
+{
+    if (worker_count() == 0) {
+        return false;
+    }
+
+    Task task{};
+    auto queue_idx{ t_thread_pool == this ? t_queue_idx : 0 };
+    if ((t_thread_pool == this && pop_task(queue_idx, group, task)) || steal_task(queue_idx, group, task)) {
+        m_pending_tasks.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::worker_loop(std::size_t worker_idx)
+{
+    t_thread_pool = this;
+    t_queue_idx = worker_idx;
+
+    while (true) {
+        if (run_pending_task()) {
+            continue;
+        }
+
+        std::unique_lock lock{ m_sleep_mutex };
+        m_sleep_condition.wait(
+            lock, [this]() { return m_stop || m_pending_tasks.load(std::memory_order_acquire) != 0; });
+        if (m_stop) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::pop_task(std::size_t queue_idx, TaskGroup group, Task& task)
+{
+    auto& queue{ *m_queues[queue_idx] };
+    std::scoped_lock lock{ queue.mutex };
+
+    // The newest task of the own queue is the most likely to be cache-hot.
+    auto it{ std::find_if(queue.tasks.rbegin(), queue.tasks.rend(),
+        [&](const GroupedTask& grouped_task) { return group == nullptr || grouped_task.group == group; }) };
+    if (it == queue.tasks.rend()) {
+        return false;
+    }
+
+    task = std::move(it->task);
+    queue.tasks.erase(std::next(it).base());
+    return true;
+}
+
+bool ThreadPool::steal_task(std::size_t queue_idx, TaskGroup group, Task& task)
+{
+    for (std::size_t i{ 0 }; i < m_queues.size(); ++i) {
+        auto& queue{ *m_queues[(queue_idx + i) % m_queues.size()] };
+        std::scoped_lock lock{ queue.mutex };
+        auto it{ std::find_if(queue.tasks.begin(), queue.tasks.end(),
+            [&](const GroupedTask& grouped_task) { return group == nullptr || grouped_task.group == group; }) };
+        if (it != queue.tasks.end()) {
+            task = std::move(it->task);
+            queue.tasks.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
@@ -1,14 +1,105 @@
 #include <visualizer/Transform.hpp>
 
+#include <cassert>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define VISUALIZER_TRANSFORM_SSE
+#endif
+
 namespace Visualizer {
 
 glm::mat4 getModelMatrix(const Transform& transform)
 {
-    auto translation{ glm::translate(glm::mat4{ 1.0f }, transform.position) };
-    auto rotation{ glm::toMat4(transform.rotation) };
-    auto scale = glm::scale(glm::mat4{ 1.0f }, transform.scale);
+    // Expanded product of the translation, rotation and scale matrices, which only scales the columns of the
+    // rotation matrix and places the translation into the last column.
+    const auto& rotation{ transform.rotation };
+    const auto& scale{ transform.scale };
+    auto x{ rotation.x };
+    auto y{ rotation.y };
+    auto z{ rotation.z };
+    auto w{ rotation.w };
+    auto xx{ x * x };
+    auto yy{ y * y };
+    auto zz{ z * z };
+    auto xy{ x * y };
+    auto xz{ x * z };
+    auto yz{ y * z };
+    auto wx{ w * x };
+    auto wy{ w * y };
+    auto wz{ w * z };
+
+    return glm::mat4{
+        glm::vec4{ (1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f },
+        glm::vec4{ 2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f },
+        glm::vec4{ 2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f },
+        glm::vec4{ transform.position, 1.0f },
+    };
+}
+
+void getModelMatrices(std::span<const Transform> transforms, std::span<glm::mat4> matrices)
+{
+    assert(transforms.size() == matrices.size());
+    std::size_t i{ 0 };
+
+#ifdef VISUALIZER_TRANSFORM_SSE
+    // Computes four matrices at a time, with one lane per transform. The columns are transposed back into the
+    // layout of the matrices before they are stored.
+    auto load{ [&](auto member) {
+        return _mm_setr_ps(member(transforms[i]), member(transforms[i + 1]), member(transforms[i + 2]),
+            member(transforms[i + 3]));
+    } };
+    auto store{ [&](std::size_t column, __m128 c0, __m128 c1, __m128 c2, __m128 c3) {
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(&matrices[i][column][0], c0);
+        _mm_storeu_ps(&matrices[i + 1][column][0], c1);
+        _mm_storeu_ps(&matrices[i + 2][column][0], c2);
+        _mm_storeu_ps(&matrices[i + 3][column][0], c3);
+    } };
 
-    return translation * rotation * scale;
+    const auto zero{ _mm_setzero_ps() };
+    const auto one{ _mm_set1_ps(1.0f) };
+    const auto two{ _mm_set1_ps(2.0f) };
+    for (; i + 4 <= transforms.size(); i += 4) {
+        auto x{ load([](const Transform& transform) { return transform.rotation.x; }) };
+        auto y{ load([](const Transform& transform) { return transform.rotation.y; }) };
+        auto z{ load([](const Transform& transform) { return transform.rotation.z; }) };
+        auto w{ load([](const Transform& transform) { return transform.rotation.w; }) };
+
+        auto x2{ _mm_mul_ps(x, two) };
+        auto y2{ _mm_mul_ps(y, two) };
+        auto z2{ _mm_mul_ps(z, two) };
+        auto xx{ _mm_mul_ps(x, x2) };
+        auto yy{ _mm_mul_ps(y, y2) };
+        auto zz{ _mm_mul_ps(z, z2) };
+        auto xy{ _mm_mul_ps(x, y2) };
+        auto xz{ _mm_mul_ps(x, z2) };
+        auto yz{ _mm_mul_ps(y, z2) };
+        auto wx{ _mm_mul_ps(w, x2) };
+        auto wy{ _mm_mul_ps(w, y2) };
+        auto wz{ _mm_mul_ps(w, z2) };
+
+        auto sx{ load([](const Transform& transform) { return transform.scale.x; }) };
+        store(0, _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+            _mm_mul_ps(_mm_sub_ps(xz, wy), sx), zero);
+
+        auto sy{ load([](const Transform& transform) { return transform.scale.y; }) };
+        store(1, _mm_mul_ps(_mm_sub_ps(xy, wz), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+            _mm_mul_ps(_mm_add_ps(yz, wx), sy), zero);
+
+        auto sz{ load([](const Transform& transform) { return transform.scale.z; }) };
+        store(2, _mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), zero);
+
+        store(3, load([](const Transform& transform) { return transform.position.x; }),
+            load([](const Transform& transform) { return transform.position.y; }),
+            load([](const Transform& transform) { return transform.position.z; }), one);
+    }
+#endif
+
+    for (; i < transforms.size(); ++i) {
+        matrices[i] = getModelMatrix(transforms[i]);
+    }
 }
 
-}
\ No newline at end of file
+}
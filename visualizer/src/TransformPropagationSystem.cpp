@@ -0,0 +1,100 @@
+#include <visualizer/TransformPropagationSystem.hpp>
+
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace Visualizer {
+
+TransformPropagationSystem::TransformPropagationSystem()
+    : m_last_version{ 0 }
+    , m_root_query{}
+    , m_child_query{}
+    , m_traversal_stack{}
+    , m_entity_database{}
+{
+}
+
+void TransformPropagationSystem::initialize() { m_entity_database = m_world->getManager<EntityDatabase>(); }
+
+void TransformPropagationSystem::terminate()
+{
+    m_entity_database = nullptr;
+    m_traversal_stack.clear();
+    m_last_version = 0;
+}
+
+SystemAccess TransformPropagationSystem::access() const
+{
+    // The matrices of the parents are written by the same queries, before they are read by the children.
+    SystemAccess access{};
+    m_root_query.declare_access(access);
+    m_child_query.declare_access(access);
+    return access;
+}
+
+void TransformPropagationSystem::run(void*)
+{
+    m_entity_database->enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        auto version{ database_context.global_version() };
+
+        // New and moved entities stamp the columns of their chunks, so that they are computed as well.
+        auto roots{ m_root_query.query_db_window(database_context) };
+        auto changed_roots{ roots.changed_since<Transform>(m_last_version) };
+        m_root_query.for_each_chunk(
+            changed_roots, [](std::span<const Transform> transforms, std::span<LocalToWorld> local_to_worlds) {
+                // `LocalToWorld` only wraps the matrix, the column is therefore an array of matrices.
+                auto matrices{ reinterpret_cast<glm::mat4*>(local_to_worlds.data()) };
+                getModelMatrices(transforms, { matrices, local_to_worlds.size() });
+            });
+
+        auto changed_children{ m_child_query.query_db_window(database_context).changed_since<Transform, Parent>(
+            m_last_version) };
+        if (changed_roots.chunk_size() == 0 && changed_children.chunk_size() == 0) {
+            m_last_version = version;
+            return;
+        }
+
+        // Top-down traversal of the hierarchies, so that the parents are computed before their children.
+        // Unchanged subtrees are skipped, as neither their transforms nor the matrices of their parents changed.
+        for (std::size_t chunk_idx{ 0 }; chunk_idx < roots.chunk_size(); ++chunk_idx) {
+            for (auto root : roots.chunk_entities(chunk_idx)) {
+                auto root_changed{ database_context.fetch_component_version<LocalToWorld>(root) > m_last_version };
+                push_children(database_context, root, root_changed);
+            }
+        }
+        while (!m_traversal_stack.empty()) {
+            auto [entity, parent_changed]{ m_traversal_stack.back() };
+            m_traversal_stack.pop_back();
+
+            auto changed{ parent_changed || database_context.fetch_component_version<Transform>(entity) > m_last_version
+                || database_context.fetch_component_version<Parent>(entity) > m_last_version };
+            if (changed) {
+                const auto& const_database_context{ std::as_const(database_context) };
+                auto parent_entity{ const_database_context.fetch_component_unchecked<Parent>(entity).m_parent };
+                const auto& parent_matrix{
+                    const_database_context.fetch_component_unchecked<LocalToWorld>(parent_entity).matrix
+                };
+                const auto& transform{ const_database_context.fetch_component_unchecked<Transform>(entity) };
+                database_context.fetch_component_unchecked<LocalToWorld>(entity).matrix
+                    = parent_matrix * getModelMatrix(transform);
+            }
+            push_children(database_context, entity, changed);
+        }
+        m_last_version = version;
+    });
+}
+
+void TransformPropagationSystem::push_children(
+    const EntityDatabaseLazyContext& database_context, Entity entity, bool changed)
+{
+    for (auto child : database_context.fetch_related_entities<Parent>(entity)) {
+        // Children without a transform do not take part in the hierarchy, and neither do their own children.
+        if (database_context.entity_has_component<Transform>(child)
+            && database_context.entity_has_component<LocalToWorld>(child)) {
+            m_traversal_stack.emplace_back(child, changed);
+        }
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest.h>
+
+#include <visualizer/EntityCommandBuffer.hpp>
+#include <visualizer/EntityDatabase.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+struct Position {
+    float x;
+};
+
+struct Velocity {
+    float x;
+};
+
+struct Frozen {
+};
+
+}
+
+TEST_CASE("EntityDatabase resolves the placeholders of the played back command buffers")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_component_desc<Velocity>();
+        database_context.register_component_desc<Frozen>();
+    });
+
+    Entity existing{};
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        existing = database_context.init_entity(EntityArchetype{}.with<Position, Frozen>());
+    });
+
+    EntityCommandBuffer first_buffer{};
+    auto first_placeholder{ first_buffer.init_entity(EntityArchetype{}.with<Position>()) };
+    first_buffer.add_component<Velocity>(first_placeholder, Velocity{ 2.0f });
+    first_buffer.remove_component<Frozen>(existing);
+
+    EntityCommandBuffer second_buffer{};
+    auto erased_placeholder{ second_buffer.init_entity(EntityArchetype{}.with<Position>()) };
+    auto second_placeholder{ second_buffer.init_entity(EntityArchetype{}.with<Position, Velocity>()) };
+    second_buffer.write_component<Position>(second_placeholder, Position{ 3.0f });
+    second_buffer.remove_component<Velocity>(second_placeholder);
+    second_buffer.erase_entity(erased_placeholder);
+
+    auto first_ticket{ database.submit_command_buffer(std::move(first_buffer)) };
+    auto second_ticket{ database.submit_command_buffer(std::move(second_buffer)) };
+    auto created_entities{ database.play_back_command_buffers() };
+    CHECK(created_entities.size() == 3);
+
+    auto first_entity{ database.resolve_entity(first_ticket, first_placeholder) };
+    auto second_entity{ database.resolve_entity(second_ticket, second_placeholder) };
+    CHECK(EntityCommandBuffer::is_deferred(database.resolve_entity(second_ticket, erased_placeholder)));
+    CHECK_FALSE(EntityCommandBuffer::is_deferred(first_entity));
+    CHECK_FALSE(EntityCommandBuffer::is_deferred(second_entity));
+
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        REQUIRE(database_context.has_entity(first_entity));
+        CHECK(database_context.entity_has_component<Position>(first_entity));
+        CHECK(database_context.entity_has_component<Velocity>(first_entity));
+        CHECK(database_context.read_component<Velocity>(first_entity).x == 2.0f);
+
+        REQUIRE(database_context.has_entity(second_entity));
+        CHECK(database_context.entity_has_component<Position>(second_entity));
+        CHECK_FALSE(database_context.entity_has_component<Velocity>(second_entity));
+        CHECK(database_context.read_component<Position>(second_entity).x == 3.0f);
+
+        CHECK(database_context.entity_has_component<Position>(existing));
+        CHECK_FALSE(database_context.entity_has_component<Frozen>(existing));
+    });
+}
+
+TEST_CASE("EntityDatabase stamps the played back commands with a new version")
+{
+    EntityDatabase database{};
+    Entity entity{};
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        entity = database_context.init_entity(EntityArchetype{}.with<Position>());
+    });
+
+    auto seen_version{ database.increment_global_version() };
+    EntityCommandBuffer command_buffer{};
+    command_buffer.write_component<Position>(entity, Position{ 1.0f });
+    database.submit_command_buffer(std::move(command_buffer));
+    database.play_back_command_buffers();
+
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        CHECK(database_context.fetch_component_version<Position>(entity) > seen_version);
+    });
+}
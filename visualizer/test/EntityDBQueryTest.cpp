@@ -0,0 +1,291 @@
+#include <doctest/doctest.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <visualizer/EntityDBQuery.hpp>
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/TypedQuery.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+struct Position {
+    float x;
+};
+
+struct Highlight {
+    int color;
+};
+
+struct Material {
+    int id;
+
+    bool operator==(const Material& other) const = default;
+};
+
+struct Selected {
+    bool operator==(const Selected& other) const = default;
+};
+
+struct Visible {
+    int layer;
+};
+
+}
+
+TEST_CASE("EntityDBWindow fetches sparse components next to the components of the chunks")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_sparse_component_desc<Highlight>();
+
+        std::vector<Entity> entities{};
+        for (std::size_t i{ 0 }; i < 8; ++i) {
+            auto entity{ database_context.init_entity(EntityArchetype{}.with<Position>()) };
+            database_context.write_component(entity, Position{ static_cast<float>(i) });
+            if (i % 2 == 0) {
+                database_context.add_component(entity, Highlight{ static_cast<int>(i) });
+            }
+            entities.push_back(entity);
+        }
+
+        // Erasing moves the last entities of the chunk and of the sparse set into the freed slots.
+        database_context.erase_entity(entities[0]);
+        database_context.erase_entity(entities[3]);
+
+        auto window{ EntityDBQuery{}
+                         .with_component<Position>()
+                         .with_optional_component<Highlight>()
+                         .query_db_window(database_context) };
+        REQUIRE(window.size() == 6);
+        CHECK_FALSE(window.has_entity(entities[0]));
+        CHECK_FALSE(window.has_entity(entities[3]));
+
+        auto position_idx{ window.component_idx(getComponentType<Position>()) };
+        auto highlight_idx{ window.component_idx(getComponentType<Highlight>()) };
+        for (std::size_t i{ 1 }; i < entities.size(); ++i) {
+            if (i == 3) {
+                continue;
+            }
+
+            auto entity_idx{ window.entity_idx(entities[i]) };
+            auto position{ static_cast<const Position*>(window.fetch_component_unchecked(entity_idx, position_idx)) };
+            auto highlight{ static_cast<const Highlight*>(
+                std::as_const(window).fetch_component_unchecked(entity_idx, highlight_idx)) };
+            REQUIRE(position != nullptr);
+            CHECK(position->x == static_cast<float>(i));
+            CHECK(window.entity_has_component(entities[i], getComponentType<Highlight>()) == (i % 2 == 0));
+            if (i % 2 == 0) {
+                REQUIRE(highlight != nullptr);
+                CHECK(highlight->color == static_cast<int>(i));
+            } else {
+                CHECK(highlight == nullptr);
+            }
+        }
+
+        auto highlighted{ EntityDBQuery{}.with_component<Position, Highlight>().query_db_window(database_context) };
+        CHECK(highlighted.size() == 3);
+        for (std::size_t i{ 2 }; i < entities.size(); i += 2) {
+            CHECK(highlighted.has_entity(entities[i]));
+        }
+    });
+}
+
+TEST_CASE("EntityDBWindow iterates sparse components per entity together with the components of the chunks")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_sparse_component_desc<Highlight>();
+
+        std::vector<Entity> entities{};
+        for (std::size_t i{ 0 }; i < 8; ++i) {
+            auto entity{ database_context.init_entity(EntityArchetype{}.with<Position>()) };
+            database_context.write_component(entity, Position{ static_cast<float>(i) });
+            if (i % 2 == 0) {
+                database_context.add_component(entity, Highlight{ static_cast<int>(i) });
+            }
+            entities.push_back(entity);
+        }
+
+        auto highlighted{ EntityDBQuery{}.with_component<Position, Highlight>().query_db_window(database_context) };
+        std::size_t visited{ 0 };
+        highlighted.for_each<Position, Highlight>([&](Position* position, Highlight* highlight) {
+            REQUIRE(highlight != nullptr);
+            CHECK(static_cast<float>(highlight->color) == position->x);
+            highlight->color += 10;
+            visited++;
+        });
+        CHECK(visited == 4);
+
+        auto window{ EntityDBQuery{}
+                         .with_component<Position>()
+                         .with_optional_component<Highlight>()
+                         .query_db_window(database_context) };
+        auto filtered{ window.filter<Position, Highlight>([](const Position*, const Highlight* highlight) {
+            return highlight != nullptr && highlight->color > 11;
+        }) };
+        CHECK(filtered.size() == 3);
+        window.for_each<const Position, const Highlight>(
+            [&](Entity entity, const Position* position, const Highlight* highlight) {
+                auto i{ static_cast<std::size_t>(position->x) };
+                CHECK(entity == entities[i]);
+                if (i % 2 == 0) {
+                    REQUIRE(highlight != nullptr);
+                    CHECK(highlight->color == static_cast<int>(i) + 10);
+                } else {
+                    CHECK(highlight == nullptr);
+                }
+            });
+
+        TypedQuery<Read<Position>, Read<Highlight>> typed_query{};
+        visited = 0;
+        typed_query.for_each(database_context, [&](const Position& position, const Highlight& highlight) {
+            CHECK(highlight.color == static_cast<int>(position.x) + 10);
+            visited++;
+        });
+        CHECK(visited == 4);
+    });
+}
+
+TEST_CASE("EntityDBWindow hands out the values of shared components and tags per entity")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_shared_component_desc<Material>();
+        database_context.register_shared_component_desc<Selected>();
+
+        for (std::size_t i{ 0 }; i < 6; ++i) {
+            auto entity{ database_context.init_entity(EntityArchetype{}.with<Position, Material>()) };
+            database_context.write_component(entity, Position{ static_cast<float>(i) });
+            database_context.write_component(entity, Material{ static_cast<int>(i % 3) });
+            if (i < 2) {
+                database_context.add_component<Selected>(entity);
+            }
+        }
+
+        auto window{ EntityDBQuery{}
+                         .with_component<Position, Material>()
+                         .with_optional_component<Selected>()
+                         .query_db_window(database_context) };
+        REQUIRE(window.size() == 6);
+        std::size_t selected{ 0 };
+        window.for_each<const Position, const Material, Selected>(
+            [&](Entity entity, const Position* position, const Material* material, Selected* tag) {
+                REQUIRE(material != nullptr);
+                CHECK(material->id == static_cast<int>(position->x) % 3);
+                CHECK(window.entity_has_component(entity, getComponentType<Material>()));
+                CHECK(window.entity_has_component(entity, getComponentType<Selected>()) == (tag != nullptr));
+                CHECK((tag != nullptr) == (position->x < 2.0f));
+                selected += tag != nullptr ? 1 : 0;
+            });
+        CHECK(selected == 2);
+
+        TypedQuery<Read<Position>, Read<Material>, Read<Selected>> typed_query{};
+        selected = 0;
+        typed_query.for_each(
+            database_context, [&](const Position& position, const Material& material, const Selected&) {
+                CHECK(material.id == static_cast<int>(position.x) % 3);
+                selected++;
+            });
+        CHECK(selected == 2);
+    });
+}
+
+TEST_CASE("EntityDBWindow splits the chunks around disabled entities and skips fully disabled chunks")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_enableable_component_desc<Visible>();
+        for (std::size_t i{ 0 }; i < 4096; ++i) {
+            database_context.init_entity(EntityArchetype{}.with<Position, Visible>());
+        }
+
+        auto query{ EntityDBQuery{}.with_component<Position, Visible>() };
+        std::vector<std::vector<Entity>> chunk_entities{};
+        auto window{ query.query_db_window(database_context) };
+        window.iterate_chunk<const Position>(
+            [&](std::size_t, std::span<const Entity> entities, std::span<const Position>) {
+                chunk_entities.emplace_back(entities.begin(), entities.end());
+            });
+        REQUIRE(chunk_entities.size() > 2);
+        REQUIRE(chunk_entities[0].size() > 12);
+
+        for (std::size_t idx : { 3, 4, 10 }) {
+            database_context.set_component_enabled<Visible>(chunk_entities[0][idx], false);
+        }
+        for (auto entity : chunk_entities[1]) {
+            database_context.set_component_enabled<Visible>(entity, false);
+        }
+
+        auto enabled{ query.query_db_window(database_context) };
+        CHECK(enabled.size() == 4096 - 3 - chunk_entities[1].size());
+        CHECK(enabled.chunk_size() == 3 + chunk_entities.size() - 2);
+        std::vector<std::size_t> run_sizes{};
+        enabled.iterate_chunk<const Position>(
+            [&](std::size_t, std::span<const Entity> entities, std::span<const Position>) {
+                run_sizes.push_back(entities.size());
+                for (auto entity : entities) {
+                    CHECK(database_context.is_component_enabled<Visible>(entity));
+                }
+            });
+        REQUIRE(run_sizes.size() >= 3);
+        CHECK(run_sizes[0] == 3);
+        CHECK(run_sizes[1] == 5);
+        CHECK(run_sizes[2] == chunk_entities[0].size() - 11);
+    });
+}
+
+TEST_CASE("EntityDatabase toggles the enabled bits of neighbouring entities from concurrent lazy contexts")
+{
+    constexpr std::size_t thread_count{ 4 };
+    constexpr std::size_t entity_count{ 1024 };
+
+    EntityDatabase database{};
+    std::vector<Entity> entities{};
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.register_enableable_component_desc<Visible>();
+        for (std::size_t i{ 0 }; i < entity_count; ++i) {
+            entities.push_back(database_context.init_entity(EntityArchetype{}.with<Visible>()));
+        }
+    });
+
+    // The threads toggle interleaved entities, so that they all write to the same words of the chunks.
+    auto disable{ [&](std::size_t first_entity, std::size_t stride) {
+        std::vector<std::thread> threads{};
+        for (std::size_t thread_idx{ 0 }; thread_idx < thread_count; ++thread_idx) {
+            threads.emplace_back([&, thread_idx]() {
+                database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+                    for (auto i{ first_entity + thread_idx * stride }; i < entity_count; i += thread_count * stride) {
+                        database_context.set_component_enabled<Visible>(entities[i], false);
+                    }
+                });
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    } };
+
+    disable(0, 2);
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        auto window{ EntityDBQuery{}.with_component<Visible>().query_db_window(database_context) };
+        CHECK(window.size() == entity_count / 2);
+        for (std::size_t i{ 0 }; i < entity_count; ++i) {
+            CHECK(database_context.is_component_enabled<Visible>(entities[i]) == (i % 2 == 1));
+        }
+    });
+
+    disable(1, 2);
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        auto window{ EntityDBQuery{}.with_component<Visible>().query_db_window(database_context) };
+        CHECK(window.size() == 0);
+        CHECK(window.chunk_size() == 0);
+    });
+}
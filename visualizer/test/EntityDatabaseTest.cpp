@@ -0,0 +1,89 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+
+#include <visualizer/EntityDatabase.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+struct Position {
+    float x;
+};
+
+struct Material {
+    int id;
+
+    bool operator==(const Material& other) const = default;
+};
+
+}
+
+TEST_CASE("EntityDatabase moves entities between containers of shared components in both directions")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_shared_component_desc<Material>();
+
+        auto first_entity{ database_context.init_entity(EntityArchetype{}.with<Position, Material>()) };
+        auto second_entity{ database_context.init_entity(EntityArchetype{}.with<Position>()) };
+
+        // Removing the shared component and adding it to another entity walks the same pair of containers.
+        database_context.remove_component<Material>(first_entity);
+        database_context.add_component<Material>(second_entity);
+        CHECK_FALSE(database_context.entity_has_component<Material>(first_entity));
+        CHECK(database_context.entity_has_component<Material>(second_entity));
+
+        database_context.add_component<Material>(first_entity, Material{ 1 });
+        database_context.remove_component<Material>(second_entity);
+        database_context.add_component<Material>(second_entity);
+        CHECK(database_context.read_component<Material>(first_entity).id == 1);
+        CHECK(database_context.read_component<Material>(second_entity).id == 0);
+
+        database_context.remove_component<Material>(first_entity);
+        database_context.add_component<Material>(first_entity);
+        CHECK(database_context.read_component<Material>(first_entity).id == 0);
+        CHECK(database_context.read_component<Position>(first_entity).x == 0.0f);
+    });
+}
+
+namespace {
+
+struct ChildOf {
+    Entity parent;
+};
+
+}
+
+TEST_CASE("EntityDatabase keeps looked up related entities valid while the relationship changes")
+{
+    EntityDatabase database{};
+    database.enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Position>();
+        database_context.register_relationship_component_desc<ChildOf, &ChildOf::parent>();
+
+        auto first_parent{ database_context.init_entity(EntityArchetype{}.with<Position>()) };
+        auto second_parent{ database_context.init_entity(EntityArchetype{}.with<Position>()) };
+        auto first_child{ database_context.init_entity(EntityArchetype{}.with<ChildOf>()) };
+        auto second_child{ database_context.init_entity(EntityArchetype{}.with<ChildOf>()) };
+        database_context.write_component(first_child, ChildOf{ first_parent });
+        database_context.write_component(second_child, ChildOf{ first_parent });
+
+        auto children{ database_context.fetch_related_entities<ChildOf>(first_parent) };
+        REQUIRE(children.size() == 2);
+
+        // Changing the relationship rebuilds the index on the next lookup, which must not affect the earlier result.
+        database_context.write_component(second_child, ChildOf{ second_parent });
+        auto third_child{ database_context.init_entity(EntityArchetype{}.with<ChildOf>()) };
+        database_context.write_component(third_child, ChildOf{ second_parent });
+        auto moved_children{ database_context.fetch_related_entities<ChildOf>(second_parent) };
+        REQUIRE(moved_children.size() == 2);
+        CHECK(database_context.fetch_related_entities<ChildOf>(first_parent).size() == 1);
+
+        CHECK(children.size() == 2);
+        CHECK(std::find(children.begin(), children.end(), first_child) != children.end());
+        CHECK(std::find(children.begin(), children.end(), second_child) != children.end());
+    });
+}
@@ -0,0 +1,115 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <visualizer/EntityDatabase.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+struct Health {
+    int value;
+};
+
+}
+
+TEST_CASE("EntityDatabase publishes the writes of concurrent lazy contexts at the sync point")
+{
+    constexpr std::size_t thread_count{ 4 };
+    constexpr std::size_t entities_per_thread{ 64 };
+
+    EntityDatabase database{};
+    EntityObserverId observer_id{};
+    std::vector<Entity> entities{};
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Health>();
+        observer_id = database_context.register_observer<Health>();
+        for (std::size_t i{ 0 }; i < thread_count * entities_per_thread; ++i) {
+            entities.push_back(database_context.init_entity(EntityArchetype{}.with<Health>()));
+        }
+    });
+
+    database.play_back_command_buffers();
+    database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        auto observation{ database_context.take_observation(observer_id) };
+        CHECK(observation.added.size() == entities.size());
+        CHECK(observation.written.empty());
+    });
+
+    std::vector<std::thread> threads{};
+    for (std::size_t thread_idx{ 0 }; thread_idx < thread_count; ++thread_idx) {
+        threads.emplace_back([&, thread_idx]() {
+            database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+                for (std::size_t i{ 0 }; i < entities_per_thread; ++i) {
+                    auto entity{ entities[thread_idx * entities_per_thread + i] };
+                    database_context.fetch_component_unchecked<Health>(entity).value++;
+                    database_context.write_component(entity, Health{ 2 });
+                }
+            });
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Nothing is published before the sync point.
+    database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        CHECK(database_context.take_observation(observer_id).empty());
+    });
+
+    database.play_back_command_buffers();
+    database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        auto observation{ database_context.take_observation(observer_id) };
+        CHECK(observation.added.empty());
+        CHECK(observation.removed.empty());
+        REQUIRE(observation.written.size() == entities.size());
+        for (auto entity : entities) {
+            CHECK(std::find(observation.written.begin(), observation.written.end(), entity)
+                != observation.written.end());
+        }
+    });
+}
+
+TEST_CASE("EntityDatabase reports the net changes of an entity between the sync points")
+{
+    EntityDatabase database{};
+    EntityObserverId observer_id{};
+    Entity transient{};
+    Entity replaced{};
+    Entity erased{};
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Health>();
+        observer_id = database_context.register_observer<Health>();
+        replaced = database_context.init_entity(EntityArchetype{}.with<Health>());
+        erased = database_context.init_entity(EntityArchetype{}.with<Health>());
+    });
+    database.play_back_command_buffers();
+
+    database.enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.take_observation(observer_id);
+
+        transient = database_context.init_entity(EntityArchetype{});
+        database_context.add_component<Health>(transient);
+        database_context.remove_component<Health>(transient);
+
+        database_context.remove_component<Health>(replaced);
+        database_context.add_component<Health>(replaced, Health{ 3 });
+
+        database_context.remove_component<Health>(erased);
+        database_context.add_component<Health>(erased);
+        database_context.erase_entity(erased);
+    });
+    database.play_back_command_buffers();
+
+    database.enter_secure_lazy_context([&](EntityDatabaseLazyContext& database_context) {
+        auto observation{ database_context.take_observation(observer_id) };
+        CHECK(observation.added.empty());
+        REQUIRE(observation.removed.size() == 1);
+        CHECK(observation.removed[0] == erased);
+        REQUIRE(observation.written.size() == 1);
+        CHECK(observation.written[0] == replaced);
+    });
+}
@@ -0,0 +1,97 @@
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/SystemManager.hpp>
+#include <visualizer/ThreadPool.hpp>
+#include <visualizer/World.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+struct Counter {
+    int value;
+};
+
+struct RunLog {
+    std::mutex mutex;
+    std::vector<std::size_t> systems;
+};
+
+template <std::size_t Index> class CounterSystem : public System {
+public:
+    explicit CounterSystem(RunLog& log)
+        : m_log{ &log }
+    {
+    }
+
+    void run(void*) override
+    {
+        // Without a dependency on the first system, the later ones would overtake it.
+        if constexpr (Index == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+        }
+
+        auto entity_database{ m_world->getManager<EntityDatabase>() };
+        entity_database->enter_secure_lazy_context([](EntityDatabaseLazyContext& database_context) {
+            EntityDBQuery{}.with_component<Counter>().query_db_window(database_context).for_each<Counter>(
+                [](Counter* counter) { counter->value++; });
+        });
+
+        std::scoped_lock lock{ m_log->mutex };
+        m_log->systems.push_back(Index);
+    }
+
+    void initialize() override { }
+    void terminate() override { }
+
+    SystemAccess access() const override
+    {
+        SystemAccess access{};
+        access.write<Counter>(EntityDBQuery{}.with_component<Counter>());
+        return access;
+    }
+
+private:
+    RunLog* m_log;
+};
+
+}
+
+TEST_CASE("SystemManager runs conflicting systems in the order in which they were added")
+{
+    World world{};
+    auto entity_database{ world.addManager<EntityDatabase>() };
+    world.addManager<ThreadPool>(4);
+    auto system_manager{ world.addManager<SystemManager>() };
+
+    entity_database->enter_secure_context([](EntityDatabaseContext& database_context) {
+        database_context.register_component_desc<Counter>();
+        for (std::size_t i{ 0 }; i < 16; ++i) {
+            database_context.init_entity(EntityArchetype{}.with<Counter>());
+        }
+    });
+
+    RunLog log{};
+    system_manager->addSystem<CounterSystem<0>>("pass", log);
+    system_manager->addSystem<CounterSystem<1>>("pass", log);
+    system_manager->addSystem<CounterSystem<2>>("pass", log);
+    system_manager->addSystem<CounterSystem<3>>("pass", log);
+
+    for (std::size_t i{ 0 }; i < 3; ++i) {
+        log.systems.clear();
+        system_manager->run("pass");
+        CHECK(log.systems == std::vector<std::size_t>{ 0, 1, 2, 3 });
+    }
+
+    entity_database->enter_secure_context([](EntityDatabaseContext& database_context) {
+        EntityDBQuery{}.with_component<Counter>().query_db_window(database_context).for_each<const Counter>(
+            [](const Counter* counter) { CHECK(counter->value == 12); });
+    });
+}
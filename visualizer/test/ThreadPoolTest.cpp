@@ -0,0 +1,39 @@
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <visualizer/ThreadPool.hpp>
+
+using namespace Visualizer;
+
+TEST_CASE("ThreadPool only helps with the tasks of its own parallel_for while waiting")
+{
+    ThreadPool thread_pool{ 1 };
+
+    // Occupy the only worker, so that the caller has to run the tasks of the parallel_for itself.
+    std::atomic<bool> worker_blocked{ false };
+    std::atomic<bool> release_worker{ false };
+    thread_pool.submit([&]() {
+        worker_blocked = true;
+        while (!release_worker) {
+            std::this_thread::yield();
+        }
+    });
+    while (!worker_blocked) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<bool> foreign_task_ran{ false };
+    thread_pool.submit([&]() { foreign_task_ran = true; });
+
+    std::atomic<std::size_t> completed_tasks{ 0 };
+    thread_pool.parallel_for(8, [&](std::size_t) { completed_tasks++; });
+    CHECK(completed_tasks == 8);
+    CHECK_FALSE(foreign_task_ran);
+
+    release_worker = true;
+    while (!foreign_task_ran) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest.h>
+
+#include <optional>
+
+#include <visualizer/EntityDatabase.hpp>
+#include <visualizer/LocalToWorld.hpp>
+#include <visualizer/Parent.hpp>
+#include <visualizer/SystemManager.hpp>
+#include <visualizer/Transform.hpp>
+#include <visualizer/TransformPropagationSystem.hpp>
+#include <visualizer/World.hpp>
+
+using namespace Visualizer;
+
+namespace {
+
+// Keeps the second hierarchy in containers of its own, so that its chunks are not stamped by the first one.
+struct Marker {
+    int value;
+};
+
+Transform translation(float x)
+{
+    return Transform{ glm::identity<glm::quat>(), glm::vec3{ x, 0.0f, 0.0f }, glm::vec3{ 1.0f } };
+}
+
+float translation_x(EntityDatabaseContext& database_context, Entity entity)
+{
+    return database_context.fetch_component_unchecked<LocalToWorld>(entity).matrix[3].x;
+}
+
+}
+
+TEST_CASE("TransformPropagationSystem recomputes the children of changed parents and skips unchanged subtrees")
+{
+    World world{};
+    auto entity_database{ world.addManager<EntityDatabase>() };
+    auto system_manager{ world.addManager<SystemManager>() };
+
+    Entity root{};
+    Entity child{};
+    Entity grandchild{};
+    Entity other_root{};
+    Entity other_child{};
+    entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.register_relationship_component_desc<Parent, &Parent::m_parent>();
+        database_context.register_component_desc<Transform>();
+        database_context.register_component_desc<LocalToWorld>();
+        database_context.register_component_desc<Marker>();
+
+        auto init{ [&](const EntityArchetype& archetype, float x, std::optional<Entity> parent) {
+            auto entity{ database_context.init_entity(parent ? archetype.with<Parent>() : archetype) };
+            database_context.write_component(entity, translation(x));
+            if (parent) {
+                database_context.write_component(entity, Parent{ *parent });
+            }
+            return entity;
+        } };
+        auto archetype{ EntityArchetype{}.with<Transform, LocalToWorld>() };
+        auto other_archetype{ EntityArchetype{}.with<Transform, LocalToWorld, Marker>() };
+        root = init(archetype, 1.0f, std::nullopt);
+        child = init(archetype, 2.0f, root);
+        grandchild = init(archetype, 4.0f, child);
+        other_root = init(other_archetype, 8.0f, std::nullopt);
+        other_child = init(other_archetype, 16.0f, other_root);
+    });
+
+    system_manager->addSystem<TransformPropagationSystem>("update");
+    system_manager->run("update");
+    entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+        CHECK(translation_x(database_context, root) == 1.0f);
+        CHECK(translation_x(database_context, child) == 3.0f);
+        CHECK(translation_x(database_context, grandchild) == 7.0f);
+        CHECK(translation_x(database_context, other_root) == 8.0f);
+        CHECK(translation_x(database_context, other_child) == 24.0f);
+    });
+
+    // The writes happen after the run, like the writes of the other systems of the pass.
+    entity_database->increment_global_version();
+    entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+        database_context.write_component(root, translation(32.0f));
+        database_context.write_component(other_child, LocalToWorld{ glm::mat4{ 0.0f } });
+    });
+
+    // The subtree of the changed root is recomputed, while the matrix of the unchanged one is left as it was.
+    system_manager->run("update");
+    entity_database->enter_secure_context([&](EntityDatabaseContext& database_context) {
+        CHECK(translation_x(database_context, root) == 32.0f);
+        CHECK(translation_x(database_context, child) == 34.0f);
+        CHECK(translation_x(database_context, grandchild) == 38.0f);
+        CHECK(translation_x(database_context, other_root) == 8.0f);
+        CHECK(translation_x(database_context, other_child) == 0.0f);
+    });
+}